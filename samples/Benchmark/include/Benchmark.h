@@ -0,0 +1,156 @@
+/*
+* 
+* Copyright (c) 2012, Ban the Rewind
+* All rights reserved.
+* 
+* Redistribution and use in source and binary forms, with or 
+* without modification, are permitted provided that the following 
+* conditions are met:
+* 
+* Redistributions of source code must retain the above copyright 
+* notice, this list of conditions and the following disclaimer.
+* Redistributions in binary form must reproduce the above copyright 
+* notice, this list of conditions and the following disclaimer in 
+* the documentation and/or other materials provided with the 
+* distribution.
+* 
+* Neither the name of the Ban the Rewind nor the names of its 
+* contributors may be used to endorse or promote products 
+* derived from this software without specific prior written 
+* permission.
+* 
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS 
+* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT 
+* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS 
+* FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE 
+* COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, 
+* INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+* BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; 
+* LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+* CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, 
+* STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) 
+* ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF 
+* ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+* 
+*/
+
+#pragma once
+
+// Includes
+#include "boost/atomic.hpp"
+#include "cinder/Timer.h"
+#include "Emotiv.h"
+#include <string>
+#include <vector>
+
+// Pointer alias
+typedef std::shared_ptr<class Benchmark> BenchmarkRef;
+
+/*
+ * Measures how long the Emotiv block takes to turn an engine event 
+ * into a callback. Events come from a simulated engine, or from a 
+ * recorded session when started with "--play <file>". After a 
+ * one second warm-up, every dispatched event is profiled and the 
+ * latency of each stage is reported as p50 / p99 / max, along with 
+ * sustained events per second, process CPU time per event and 
+ * heap allocations per event.
+ *
+ * With "--kernels", the vector kernels used by the analysis path 
+ * are timed instead, once per instruction set this CPU supports, 
+ * and their speedup over the scalar versions is reported.
+ *
+ * The benchmark needs no window. BenchmarkApp shows it in one, 
+ * BenchmarkConsole runs it from a terminal.
+ *
+ * Options:
+ *   --play <file>      Replay a recorded session
+ *   --speed <x>        Playback speed, 0 for as fast as possible (default)
+ *   --users <n>        Simulated headsets (default 4)
+ *   --rate <n>         EmoStates per second per simulated headset (default 128)
+ *   --window <n>       FFT window size in samples (default 128)
+ *   --hop <n>          FFT hop size, 0 for once per window (default 0)
+ *   --threads <n>      DSP worker threads (default 0)
+ *   --batch <n>        Count events with a batch callback of up to n 
+ *                      events instead of one call per event
+ *   --seconds <n>      Measuring time (default 10)
+ *   --kernels          Benchmark vector kernels only
+ *   --quit             Quit after reporting (the console always does)
+ *
+ * Allocations per event are only counted when the block is built 
+ * with EMOTIV_COUNT_ALLOCATIONS.
+ */
+class Benchmark 
+{
+
+public:
+
+	// Creates pointer to benchmark, reading options from "args". 
+	// The first argument is the program name.
+	static BenchmarkRef			create( const std::vector<std::string> &args );
+
+	// Destructor. Stops the event source.
+	~Benchmark();
+
+	// Starts the event source, or runs the kernel benchmark. 
+	// Returns false if the event source can't be started.
+	bool						start();
+
+	// Stops the event source
+	void						stop();
+
+	// Collects timings. Call regularly until it returns true, 
+	// once the report is ready.
+	bool						update();
+
+	// State
+	bool						isMeasuring() const { return mMeasuring; }
+	bool						isReported() const { return mReported; }
+	bool						isQuitting() const { return mQuit; }
+
+	// Report lines, empty until the report is ready
+	const std::vector<std::string> &	getReport() const { return mReport; }
+
+	// Emotiv callbacks
+	void						onBatch( const EmotivEvent *events, uint32_t count );
+	void						onData( const EmotivEvent &event );
+
+private:
+
+	// Constructor
+	Benchmark( const std::vector<std::string> &args );
+
+	// Emotiv
+	int32_t						mCallbackId;
+	EmotivRef					mEmotiv;
+
+	// Options
+	uint32_t					mBatchSize;
+	bool						mKernels;
+	std::string					mPlayPath;
+	float						mPlaySpeed;
+	bool						mQuit;
+	double						mSeconds;
+	uint32_t					mStateRate;
+	uint32_t					mNumThreads;
+	uint32_t					mNumUsers;
+	uint32_t					mFftHopSize;
+	uint32_t					mFftWindowSize;
+	void						parseArgs( const std::vector<std::string> &args );
+
+	// Measurement
+	double						mCpuStartTime;
+	boost::atomic<uint64_t>		mEventCount;
+	bool						mMeasuring;
+	bool						mReported;
+	double						mStartTime;
+	ci::Timer					mTimer;
+	std::vector<EmotivTiming>	mTimings;
+
+	// Times each vector kernel and reports speedups
+	void						benchmarkKernels();
+
+	// Builds the report
+	void						report();
+	std::vector<std::string>	mReport;
+
+};
@@ -0,0 +1,403 @@
+/*
+* 
+* Copyright (c) 2012, Ban the Rewind
+* All rights reserved.
+* 
+* Redistribution and use in source and binary forms, with or 
+* without modification, are permitted provided that the following 
+* conditions are met:
+* 
+* Redistributions of source code must retain the above copyright 
+* notice, this list of conditions and the following disclaimer.
+* Redistributions in binary form must reproduce the above copyright 
+* notice, this list of conditions and the following disclaimer in 
+* the documentation and/or other materials provided with the 
+* distribution.
+* 
+* Neither the name of the Ban the Rewind nor the names of its 
+* contributors may be used to endorse or promote products 
+* derived from this software without specific prior written 
+* permission.
+* 
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS 
+* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT 
+* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS 
+* FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE 
+* COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, 
+* INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+* BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; 
+* LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+* CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, 
+* STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) 
+* ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF 
+* ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+* 
+*/
+
+// Includes
+#include "Benchmark.h"
+#include "cinder/Rand.h"
+#include "cinder/Utilities.h"
+#include "EmotivKernels.h"
+#include "EmotivSimulator.h"
+#include <algorithm>
+#include <ctime>
+#include <sstream>
+#ifdef CINDER_MSW
+#include <windows.h>
+#endif
+
+// Imports
+using namespace ci;
+using namespace std;
+
+// Warm-up before measuring, in seconds
+static const double WARM_UP_SECONDS = 1.0;
+
+// Process CPU time, user and kernel, in seconds
+static double getCpuSeconds()
+{
+#ifdef CINDER_MSW
+	FILETIME creationTime, exitTime, kernelTime, userTime;
+	if ( !GetProcessTimes( GetCurrentProcess(), &creationTime, &exitTime, &kernelTime, &userTime ) ) {
+		return 0.0;
+	}
+	ULARGE_INTEGER kernel, user;
+	kernel.LowPart = kernelTime.dwLowDateTime;
+	kernel.HighPart = kernelTime.dwHighDateTime;
+	user.LowPart = userTime.dwLowDateTime;
+	user.HighPart = userTime.dwHighDateTime;
+	return (double)( kernel.QuadPart + user.QuadPart ) * 0.0000001;
+#else
+	return (double)clock() / (double)CLOCKS_PER_SEC;
+#endif
+}
+
+// Formats p50 / p99 / max of one stage in microseconds
+static string formatStage( const string &name, vector<double> &values )
+{
+	stringstream line;
+	line.precision( 1 );
+	line << fixed << name;
+	if ( values.empty() ) {
+		line << "-";
+		return line.str();
+	}
+	sort( values.begin(), values.end() );
+	size_t last = values.size() - 1;
+	line << values[ last / 2 ] * 1000000.0 << " / ";
+	line << values[ ( last * 99 ) / 100 ] * 1000000.0 << " / ";
+	line << values[ last ] * 1000000.0;
+	return line.str();
+}
+
+// Kernel benchmark block size and repetitions
+static const uint32_t KERNEL_BLOCK_SIZE = 1024;
+static const uint32_t KERNEL_REPEAT_COUNT = 20000;
+
+// Creates pointer to benchmark
+BenchmarkRef Benchmark::create( const vector<string> &args )
+{
+	return BenchmarkRef( new Benchmark( args ) );
+}
+
+// Constructor
+Benchmark::Benchmark( const vector<string> &args )
+{
+	mCallbackId = -1;
+	mCpuStartTime = 0.0;
+	mEventCount = 0;
+	mMeasuring = false;
+	mReported = false;
+	mStartTime = 0.0;
+	parseArgs( args );
+}
+
+// Destructor
+Benchmark::~Benchmark()
+{
+	stop();
+}
+
+// Time kernels at each instruction set
+void Benchmark::benchmarkKernels()
+{
+
+	// Random input. Samples sit around the EPOC's DC offset.
+	Rand random( 1 );
+	vector<double> samples( KERNEL_BLOCK_SIZE );
+	vector<float> real( KERNEL_BLOCK_SIZE );
+	vector<float> imaginary( KERNEL_BLOCK_SIZE );
+	vector<float> output( KERNEL_BLOCK_SIZE );
+	for ( uint32_t i = 0; i < KERNEL_BLOCK_SIZE; i++ ) {
+		samples[ i ] = 4200.0 + random.nextFloat( -50.0f, 50.0f );
+		real[ i ] = random.nextFloat( -1.0f, 1.0f );
+		imaginary[ i ] = random.nextFloat( -1.0f, 1.0f );
+	}
+
+	// Nanoseconds per sample for each kernel, by instruction set
+	static const int32_t KERNEL_COUNT = 4;
+	const char * names[ KERNEL_COUNT ] = { "Convert  ", "Multiply ", "Power    ", "Sum      " };
+	vector<vector<double> > times;
+	Timer timer;
+	float sink = 0.0f;
+	int32_t supportedIsa = EmotivKernels::getSupportedIsa();
+	for ( int32_t isa = EmotivKernels::ISA_SCALAR; isa <= supportedIsa; isa++ ) {
+		EmotivKernels::setIsa( isa );
+		vector<double> isaTimes( KERNEL_COUNT );
+		for ( int32_t kernel = 0; kernel < KERNEL_COUNT; kernel++ ) {
+			timer.start();
+			for ( uint32_t i = 0; i < KERNEL_REPEAT_COUNT; i++ ) {
+				switch ( kernel ) {
+				case 0:
+					EmotivKernels::convert( &samples[ 0 ], &output[ 0 ], KERNEL_BLOCK_SIZE );
+					break;
+				case 1:
+					EmotivKernels::multiply( &real[ 0 ], &imaginary[ 0 ], &output[ 0 ], KERNEL_BLOCK_SIZE );
+					break;
+				case 2:
+					EmotivKernels::power( &real[ 0 ], &imaginary[ 0 ], &output[ 0 ], KERNEL_BLOCK_SIZE );
+					break;
+				default:
+					output[ i % KERNEL_BLOCK_SIZE ] = EmotivKernels::sum( &real[ 0 ], KERNEL_BLOCK_SIZE );
+					break;
+				}
+				sink += output[ i % KERNEL_BLOCK_SIZE ];
+			}
+			isaTimes[ kernel ] = timer.getSeconds() * 1000000000.0 / (double)( KERNEL_BLOCK_SIZE * KERNEL_REPEAT_COUNT );
+		}
+		times.push_back( isaTimes );
+	}
+	EmotivKernels::setIsa( supportedIsa );
+
+	// Build lines. The sink is printed so the work is not optimized away.
+	mReport.clear();
+	mReport.push_back( "Kernels, ns/sample (speedup over scalar)" );
+	stringstream header;
+	header << "         ";
+	for ( int32_t isa = EmotivKernels::ISA_SCALAR; isa <= supportedIsa; isa++ ) {
+		header << "  " << EmotivKernels::getIsaName( isa );
+	}
+	mReport.push_back( header.str() );
+	for ( int32_t kernel = 0; kernel < KERNEL_COUNT; kernel++ ) {
+		stringstream line;
+		line.precision( 3 );
+		line << fixed << names[ kernel ];
+		for ( size_t isa = 0; isa < times.size(); isa++ ) {
+			line << "  " << times[ isa ][ kernel ];
+			if ( isa > 0 ) {
+				line.precision( 1 );
+				line << " (" << times[ 0 ][ kernel ] / times[ isa ][ kernel ] << "x)";
+				line.precision( 3 );
+			}
+		}
+		mReport.push_back( line.str() );
+	}
+	mReport.push_back( "Checksum " + toString( sink ) );
+
+}
+
+// Counts batched events. This runs on the acquisition thread.
+void Benchmark::onBatch( const EmotivEvent * /* events */, uint32_t count )
+{
+	mEventCount.fetch_add( count, boost::memory_order_relaxed );
+}
+
+// Counts callbacks. This runs on the acquisition thread.
+void Benchmark::onData( const EmotivEvent &/* event */ )
+{
+	mEventCount.fetch_add( 1, boost::memory_order_relaxed );
+}
+
+// Read command line
+void Benchmark::parseArgs( const vector<string> &args )
+{
+
+	// Defaults
+	mBatchSize = 0;
+	mFftHopSize = 0;
+	mFftWindowSize = 128;
+	mKernels = false;
+	mNumThreads = 0;
+	mNumUsers = 4;
+	mPlaySpeed = 0.0f;
+	mQuit = false;
+	mSeconds = 10.0;
+	mStateRate = 128;
+
+	// Options with values
+	for ( size_t i = 1; i < args.size(); i++ ) {
+		if ( args[ i ] == "--quit" ) {
+			mQuit = true;
+			continue;
+		}
+		if ( args[ i ] == "--kernels" ) {
+			mKernels = true;
+			continue;
+		}
+		if ( i + 1 >= args.size() ) {
+			break;
+		}
+		const string & value = args[ i + 1 ];
+		if ( args[ i ] == "--play" ) {
+			mPlayPath = value;
+		} else if ( args[ i ] == "--speed" ) {
+			mPlaySpeed = fromString<float>( value );
+		} else if ( args[ i ] == "--users" ) {
+			mNumUsers = fromString<uint32_t>( value );
+		} else if ( args[ i ] == "--rate" ) {
+			mStateRate = fromString<uint32_t>( value );
+		} else if ( args[ i ] == "--window" ) {
+			mFftWindowSize = fromString<uint32_t>( value );
+		} else if ( args[ i ] == "--hop" ) {
+			mFftHopSize = fromString<uint32_t>( value );
+		} else if ( args[ i ] == "--batch" ) {
+			mBatchSize = fromString<uint32_t>( value );
+		} else if ( args[ i ] == "--threads" ) {
+			mNumThreads = fromString<uint32_t>( value );
+		} else if ( args[ i ] == "--seconds" ) {
+			mSeconds = fromString<double>( value );
+		} else {
+			continue;
+		}
+		i++;
+	}
+
+}
+
+// Build report from the collected timings
+void Benchmark::report()
+{
+
+	// Split timings by stage
+	vector<double> decode, fetch, fft, reduce, dispatch, latency;
+	for ( vector<EmotivTiming>::const_iterator timingIt = mTimings.begin(); timingIt != mTimings.end(); ++timingIt ) {
+		decode.push_back( timingIt->mDecode );
+		fetch.push_back( timingIt->mFetch );
+		fft.push_back( timingIt->mFft );
+		reduce.push_back( timingIt->mReduce );
+		dispatch.push_back( timingIt->mDispatch );
+		latency.push_back( timingIt->mLatency );
+	}
+
+	// Throughput and CPU cost. CPU time covers the whole process, 
+	// including the simulator and any rendering.
+	double elapsed = mTimer.getSeconds() - mStartTime;
+	double cpuTime = getCpuSeconds() - mCpuStartTime;
+	uint64_t eventCount = mEventCount.load();
+	stringstream summary;
+	summary.precision( 1 );
+	summary << fixed << eventCount / elapsed << " events/s, ";
+	summary << 100.0 * cpuTime / elapsed << "% CPU, ";
+	summary << ( eventCount > 0 ? cpuTime * 1000000.0 / (double)eventCount : 0.0 ) << " us CPU/event, ";
+	summary.precision( 3 );
+	summary << mEmotiv->getAllocationsPerEvent() << " allocations/event, ";
+	summary << mTimings.size() << " events profiled";
+
+	// Build lines
+	mReport.clear();
+	mReport.push_back( mPlayPath.empty() ? "Simulated engine" : "Playback of " + mPlayPath );
+	mReport.push_back( summary.str() );
+	mReport.push_back( "Stage (us)     p50 / p99 / max" );
+	mReport.push_back( formatStage( "Decode         ", decode ) );
+	mReport.push_back( formatStage( "Raw fetch      ", fetch ) );
+	mReport.push_back( formatStage( "FFT            ", fft ) );
+	mReport.push_back( formatStage( "Band reduction ", reduce ) );
+	mReport.push_back( formatStage( "Dispatch       ", dispatch ) );
+	mReport.push_back( formatStage( "Latency        ", latency ) );
+
+}
+
+// Start benchmark
+bool Benchmark::start()
+{
+
+	// Reset measurement
+	mCpuStartTime = getCpuSeconds();
+	mEventCount = 0;
+	mMeasuring = false;
+	mReported = false;
+	mTimer.start();
+	mStartTime = mTimer.getSeconds();
+
+	// Kernel benchmark runs here and replaces the event benchmark
+	if ( mKernels ) {
+		benchmarkKernels();
+		mReported = true;
+		return true;
+	}
+
+	// Drive Emotiv from a simulator unless replaying a session
+	EmotivSimulatorRef simulator;
+	if ( mPlayPath.empty() ) {
+		simulator = EmotivSimulator::create( mNumUsers );
+		simulator->setStateRate( (float)mStateRate );
+		simulator->addBand( 1.0f, 30.0f, 10.0f );
+	}
+	mEmotiv = Emotiv::create( simulator );
+	mEmotiv->setFftWindow( mFftWindowSize, mFftHopSize );
+	mEmotiv->setThreadCount( mNumThreads );
+	mEmotiv->setPollInterval( 0.0005, 0.002 );
+	mEmotiv->setProfiling( true, 65536 );
+	if ( mBatchSize > 0 ) {
+		mEmotiv->setBatchSize( mBatchSize );
+		mCallbackId = mEmotiv->addBatchCallback<Benchmark>( &Benchmark::onBatch, this );
+	} else {
+		mCallbackId = mEmotiv->addCallback<Benchmark>( &Benchmark::onData, this );
+	}
+
+	// Start
+	bool started = mPlayPath.empty() ? mEmotiv->connect() : mEmotiv->play( mPlayPath, mPlaySpeed );
+	if ( !started ) {
+		mEmotiv.reset();
+	}
+	return started;
+
+}
+
+// Stop event source
+void Benchmark::stop()
+{
+	if ( mEmotiv ) {
+		mEmotiv->disconnect();
+	}
+}
+
+// Collect timings
+bool Benchmark::update()
+{
+
+	// Bail if done
+	if ( mReported ) {
+		return true;
+	}
+	if ( !mEmotiv ) {
+		return false;
+	}
+
+	// Collect timings. Discard everything from the simulator's 
+	// warm-up. Sessions are measured from the start since they 
+	// may be short.
+	mEmotiv->getTimings( mTimings );
+	double elapsed = mTimer.getSeconds() - mStartTime;
+	if ( !mMeasuring ) {
+		if ( elapsed >= WARM_UP_SECONDS || !mPlayPath.empty() ) {
+			mEmotiv->resetAllocationCount();
+			mEventCount = 0;
+			mMeasuring = true;
+			mCpuStartTime = getCpuSeconds();
+			mStartTime = mTimer.getSeconds();
+			mTimings.clear();
+		}
+		return false;
+	}
+
+	// Report when time is up or playback ends
+	if ( elapsed >= mSeconds || ( !mPlayPath.empty() && !mEmotiv->playing() ) ) {
+		mEmotiv->setProfiling( false );
+		report();
+		mReported = true;
+	}
+	return mReported;
+
+}
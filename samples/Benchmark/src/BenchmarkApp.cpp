@@ -0,0 +1,151 @@
+/*
+* 
+* Copyright (c) 2012, Ban the Rewind
+* All rights reserved.
+* 
+* Redistribution and use in source and binary forms, with or 
+* without modification, are permitted provided that the following 
+* conditions are met:
+* 
+* Redistributions of source code must retain the above copyright 
+* notice, this list of conditions and the following disclaimer.
+* Redistributions in binary form must reproduce the above copyright 
+* notice, this list of conditions and the following disclaimer in 
+* the documentation and/or other materials provided with the 
+* distribution.
+* 
+* Neither the name of the Ban the Rewind nor the names of its 
+* contributors may be used to endorse or promote products 
+* derived from this software without specific prior written 
+* permission.
+* 
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS 
+* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT 
+* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS 
+* FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE 
+* COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, 
+* INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+* BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; 
+* LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+* CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, 
+* STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) 
+* ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF 
+* ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+* 
+*/
+
+// Includes
+#include "Benchmark.h"
+#include "cinder/app/AppBasic.h"
+
+/*
+ * Shows the benchmark's progress and report in a window. See 
+ * Benchmark.h for options. BenchmarkConsole runs the same 
+ * benchmark from a terminal.
+ */
+class BenchmarkApp : public ci::app::AppBasic 
+{
+
+public:
+
+	// Cinder callbacks
+	void draw();
+	void prepareSettings( ci::app::AppBasic::Settings * settings );
+	void setup();
+	void shutdown();
+	void update();
+
+private:
+
+	// Benchmark
+	BenchmarkRef	mBenchmark;
+	bool			mTraced;
+
+	// Writes messages to debug console
+	void trace( const std::string &message );
+
+};
+
+// Imports
+using namespace ci;
+using namespace ci::app;
+using namespace std;
+
+// Renders
+void BenchmarkApp::draw()
+{
+	gl::clear( Colorf::black() );
+	gl::setMatricesWindow( getWindowSize() );
+	Vec2f position( 20.0f, 20.0f );
+	const vector<string> & report = mBenchmark->getReport();
+	if ( report.empty() ) {
+		gl::drawString( mBenchmark->isMeasuring() ? "Measuring..." : "Warming up...", position );
+		return;
+	}
+	for ( vector<string>::const_iterator lineIt = report.begin(); lineIt != report.end(); ++lineIt ) {
+		gl::drawString( *lineIt, position );
+		position.y += 16.0f;
+	}
+}
+
+// Prepare window settings
+void BenchmarkApp::prepareSettings( Settings * settings )
+{
+	settings->setWindowSize( 640, 240 );
+	settings->setFrameRate( 60.0f );
+	settings->setFullScreen( false );
+	settings->setTitle( "Benchmark" );
+}
+
+// Setup
+void BenchmarkApp::setup()
+{
+	mTraced = false;
+	mBenchmark = Benchmark::create( getArgs() );
+	if ( !mBenchmark->start() ) {
+		trace( "Unable to start event source" );
+		quit();
+	}
+}
+
+// Called on exit
+void BenchmarkApp::shutdown()
+{
+	if ( mBenchmark ) {
+		mBenchmark->stop();
+	}
+}
+
+// Write to console and debug window
+void BenchmarkApp::trace( const string &message )
+{
+#ifdef CINDER_MSW
+	OutputDebugStringA( ( message + "\n" ).c_str() );
+#else
+	console() << message << "\n";
+#endif
+}
+
+// Runs update logic
+void BenchmarkApp::update()
+{
+
+	// Bail if done or still measuring
+	if ( mTraced || !mBenchmark->update() ) {
+		return;
+	}
+
+	// Write report once
+	const vector<string> & report = mBenchmark->getReport();
+	for ( vector<string>::const_iterator lineIt = report.begin(); lineIt != report.end(); ++lineIt ) {
+		trace( *lineIt );
+	}
+	mTraced = true;
+	if ( mBenchmark->isQuitting() ) {
+		quit();
+	}
+
+}
+
+// Create the application
+CINDER_APP_BASIC( BenchmarkApp, RendererGl )
@@ -0,0 +1,72 @@
+/*
+* 
+* Copyright (c) 2012, Ban the Rewind
+* All rights reserved.
+* 
+* Redistribution and use in source and binary forms, with or 
+* without modification, are permitted provided that the following 
+* conditions are met:
+* 
+* Redistributions of source code must retain the above copyright 
+* notice, this list of conditions and the following disclaimer.
+* Redistributions in binary form must reproduce the above copyright 
+* notice, this list of conditions and the following disclaimer in 
+* the documentation and/or other materials provided with the 
+* distribution.
+* 
+* Neither the name of the Ban the Rewind nor the names of its 
+* contributors may be used to endorse or promote products 
+* derived from this software without specific prior written 
+* permission.
+* 
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS 
+* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT 
+* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS 
+* FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE 
+* COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, 
+* INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+* BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; 
+* LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+* CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, 
+* STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) 
+* ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF 
+* ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+* 
+*/
+
+// Includes
+#include "Benchmark.h"
+#include "boost/thread.hpp"
+#include <iostream>
+
+/*
+ * Runs the benchmark from a terminal, without a window or GL 
+ * context, and prints the report to standard output when done. 
+ * Takes the same options as BenchmarkApp (see Benchmark.h). 
+ * Returns 1 if the event source can't be started.
+ */
+int main( int argc, char * argv[] )
+{
+
+	// Start benchmark
+	std::vector<std::string> args( argv, argv + argc );
+	BenchmarkRef benchmark = Benchmark::create( args );
+	if ( !benchmark->start() ) {
+		std::cerr << "Unable to start event source" << std::endl;
+		return 1;
+	}
+
+	// Collect timings at about the app's frame rate until done
+	while ( !benchmark->update() ) {
+		boost::this_thread::sleep( boost::posix_time::milliseconds( 16 ) );
+	}
+	benchmark->stop();
+
+	// Write report
+	const std::vector<std::string> & report = benchmark->getReport();
+	for ( std::vector<std::string>::const_iterator lineIt = report.begin(); lineIt != report.end(); ++lineIt ) {
+		std::cout << *lineIt << std::endl;
+	}
+	return 0;
+
+}
@@ -48,7 +48,8 @@
  * This application demonstrates how to obtain and represent 
  * brainwave channel values as an old school feedback visualizer. 
  * Five Path2D instances represent each brainwave, leaving trails 
- * as you think.
+ * as you think. Events are queued and handled in update() so the 
+ * paths are never modified while they are being drawn.
  */
 class BrainwaveApp : public ci::app::AppBasic 
 {
@@ -63,7 +64,7 @@ public:
 	void update();
 
 	// Emotiv callback
-	void onData( EmotivEvent event );
+	void onData( const EmotivEvent &event );
 
 private:
 
@@ -162,7 +163,7 @@ void BrainwaveApp::draw()
 
 // Handles Emotiv data. The Emotiv block has already analyzed
 // the signal into channels. Just get the values from the event.
-void BrainwaveApp::onData( EmotivEvent event )
+void BrainwaveApp::onData( const EmotivEvent &event )
 {
 
 	// Shift points over by one
@@ -207,8 +208,9 @@ void BrainwaveApp::setup()
 	try
 	{
 
-		// Start Emotiv
+		// Start Emotiv. Queue events until we poll for them.
 		mEmotiv = Emotiv::create();
+		mEmotiv->setDispatchMode( Emotiv::DISPATCH_QUEUED );
 
 		// Connect to the Emotiv engine (requires connected and 
 		// active headset).
@@ -281,6 +283,11 @@ void BrainwaveApp::trace( const string &message )
 void BrainwaveApp::update()
 {
 
+	// Handle Emotiv events received since the last frame
+	if ( mEmotiv ) {
+		mEmotiv->poll();
+	}
+
 	// Update overall rotation
 	mRotation += mSpeed;
 	if ( mRotation > 360.0f ) {
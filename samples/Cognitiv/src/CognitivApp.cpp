@@ -75,7 +75,7 @@ public:
 	void update();
 
 	// Emotiv callback
-	void onData( EmotivEvent event );
+	void onData( const EmotivEvent &event );
 
 private:
 
@@ -132,7 +132,7 @@ bool CognitivApp::loadProfile( const string &profileName )
 // Handles Emotiv data. Check out the getters available
 // in the Emotiv event for access to all the data the Epoc
 // has to offer.
-void CognitivApp::onData( EmotivEvent event )
+void CognitivApp::onData( const EmotivEvent &event )
 {
 
 	// Initialize acceleration
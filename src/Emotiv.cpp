@@ -37,60 +37,178 @@
 // Include header
 #include "Emotiv.h"
 
+// Includes
+#include "EmotivEdkEngine.h"
+#include "EmotivSimulator.h"
+
 // Imports
 using namespace ci;
 using namespace ci::app;
 using namespace std;
 
+// Allocation counting hook. Building with EMOTIV_COUNT_ALLOCATIONS 
+// replaces the global allocator with one that counts calls, 
+// both overall and per thread.
+#ifdef EMOTIV_COUNT_ALLOCATIONS
+#ifdef _MSC_VER
+	#define EMOTIV_THREAD_LOCAL __declspec( thread )
+#else
+	#define EMOTIV_THREAD_LOCAL __thread
+#endif
+static boost::atomic<uint64_t>		sAllocationCount( 0 );
+static EMOTIV_THREAD_LOCAL uint64_t	sThreadAllocationCount = 0;
+void * operator new( size_t size )
+{
+	sAllocationCount.fetch_add( 1, boost::memory_order_relaxed );
+	sThreadAllocationCount++;
+	void * ptr = malloc( size > 0 ? size : 1 );
+	if ( ptr == 0 ) {
+		throw std::bad_alloc();
+	}
+	return ptr;
+}
+void * operator new[]( size_t size )
+{
+	return operator new( size );
+}
+void operator delete( void * ptr ) throw()
+{
+	free( ptr );
+}
+void operator delete[]( void * ptr ) throw()
+{
+	free( ptr );
+}
+#endif
+
+// Fraction of the way the headset clock offset moves 
+// towards a later block's offset
+static const double CLOCK_DRIFT_RATE = 0.001;
+
+// Marks a repeated sample in the gap data, in place of the 
+// number of samples lost before it
+static const int32_t GAP_DUPLICATE = -1;
+
+// Convert seconds to stored statistic time
+static uint64_t toNanoseconds( double seconds )
+{
+	return static_cast<uint64_t>( max( seconds, 0.0 ) * 1000000000.0 );
+}
+
+// Releases a locked mutex for the rest of a scope, taking it 
+// back on the way out
+class EmotivScopedUnlock
+{
+public:
+	explicit EmotivScopedUnlock( boost::mutex &mutex )
+		: mMutex( mutex )
+	{
+		mMutex.unlock();
+	}
+	~EmotivScopedUnlock()
+	{
+		mMutex.lock();
+	}
+private:
+	boost::mutex &	mMutex;
+};
+
+// Get number of allocations made by the calling thread
+static uint64_t getThreadAllocationCount()
+{
+#ifdef EMOTIV_COUNT_ALLOCATIONS
+	return sThreadAllocationCount;
+#else
+	return 0;
+#endif
+}
+
 // Create pointer to Emotiv instance
-EmotivRef Emotiv::create() 
+EmotivRef Emotiv::create( const EmotivEngineRef &engine ) 
 {
-	return EmotivRef( new Emotiv() );
+	return EmotivRef( new Emotiv( engine ) );
 }
 
 // Constructor
-Emotiv::Emotiv()
-{
-
-	// Set up target channel list
-	mTargetChannelList[ 0 ] = ED_COUNTER;
-	mTargetChannelList[ 1 ] = ED_AF3;
-	mTargetChannelList[ 2 ] = ED_F7;
-	mTargetChannelList[ 3 ] = ED_F3;
-	mTargetChannelList[ 4 ] = ED_FC5;
-	mTargetChannelList[ 5 ] = ED_T7;
-	mTargetChannelList[ 6 ] = ED_P7;
-	mTargetChannelList[ 7 ] = ED_O1;
-	mTargetChannelList[ 8 ] = ED_O2;
-	mTargetChannelList[ 9 ] = ED_P8;
-	mTargetChannelList[ 10 ] = ED_T8;
-	mTargetChannelList[ 11 ] = ED_FC6;
-	mTargetChannelList[ 12 ] = ED_F4;
-	mTargetChannelList[ 13 ] = ED_F8;
-	mTargetChannelList[ 14 ] = ED_AF4;
-	mTargetChannelList[ 15 ] = ED_GYROX;
-	mTargetChannelList[ 16 ] = ED_GYROY;
-	mTargetChannelList[ 17 ] = ED_TIMESTAMP;
-	mTargetChannelList[ 18 ] = ED_FUNC_ID;
-	mTargetChannelList[ 19 ] = ED_FUNC_VALUE;
-	mTargetChannelList[ 20 ] = ED_MARKER;
-	mTargetChannelList[ 21 ] = ED_SYNC_SIGNAL;
-
-	// Initialize frequency data
-	mFreqData = 0;
-	mFftEnabled = true;
-	mLastSampleTime = 0.0;
-	mSampleTime = 1.0;
+Emotiv::Emotiv( const EmotivEngineRef &engine )
+{
 
-	// Initialize brainwave frequencies
-	mAlpha = 0.0f;
-	mBeta = 0.0f;
-	mDelta = 0.0f;
-	mGamma = 0.0f;
-	mTheta = 0.0f;
+	// Use the EDK unless the library was built without it
+	mEngine = engine;
+	if ( !mEngine ) {
+#ifdef EMOTIV_NO_EDK
+		mEngine = EmotivSimulator::create();
+#else
+		mEngine = EmotivEdkEngine::create();
+#endif
+	}
 
-	// Initialize FFT
-	mFft = Kiss::create();
+	// Initialize state
+	setBatchSize( 64 );
+	mConnected = false;
+	mDispatchMode = DISPATCH_IMMEDIATE;
+	mEventAllocationCount = 0;
+	mEventCount = 0;
+	mRunning = false;
+
+	// Poll every 2ms while events are flowing, backing off to 32ms when idle
+	mMaxPollInterval = 0.032;
+	mPollInterval = 0.002;
+
+	// Count lost samples without filling them in
+	mGapFill = false;
+	mMaxGapFill = 32;
+
+	// Fetch raw data with each EmoState, buffering a second in between
+	mAcquisitionInterval = 0.0;
+	mDataBufferTime = 1.0;
+	mNextAcquisitionTime = 0.0;
+
+	// Initialize frequency data. The EPOC samples at 128Hz.
+	mAnalyzerType = ANALYZER_SPECTRUM;
+	mFftEnabled = true;
+	mFftHopSize = 0;
+	mFftMode = EmotivSpectrum::MODE_FFT;
+	mFftWindowFunction = EmotivSpectrum::WINDOW_HANN;
+	mFftWindowSize = 0;
+	mSampleRate = 128;
+	mSampleTime = 1.0;
+	mWelchSegmentCount = 8;
+	mWelchSegmentSize = 128;
+
+	// Remove DC offset, leave mains alone until told its frequency
+	mDcRemoval = true;
+	mNotchFrequency = 0.0f;
+
+	// Start profiling clock
+	mEventTime = 0.0;
+	mTimer.start();
+	startTiming( 0.0 );
+
+	// Clear statistics
+	for ( int32_t i = 0; i < EmotivEngine::EVENT_TYPE_COUNT; i++ ) {
+		mStatEventCounts[ i ] = 0;
+		mStatEventRates[ i ] = 0;
+		mStatWindowCounts[ i ] = 0;
+	}
+	mStatAcquisitionLatency = 0;
+	mStatCallbackTime = 0;
+	mStatCounterWraps = 0;
+	mStatFftTime = 0;
+	mStatGapCount = 0;
+	mStatLoopIterations = 0;
+	mStatQueueDepth = 0;
+	mStatSamplesAcquired = 0;
+	mStatSamplesDuplicated = 0;
+	mStatSamplesInterpolated = 0;
+	mStatSamplesLost = 0;
+	mStatWindowStart = 0.0;
+
+	// Initialize playback
+	mPlaybackEventTime = -1.0f;
+	mPlaybackSpeed = 1.0f;
+	mPlaybackStartTime = 0.0;
+	mPlaybackUserId = 0;
 
 }
 
@@ -98,23 +216,194 @@ Emotiv::Emotiv()
 Emotiv::~Emotiv()
 {
 
-	// Disconnect / clean up
+	// Disconnect / clean up. Stop the thread first, since it may be 
+	// waiting on a full event queue while it holds the lock that 
+	// stopRecording() needs.
 	mCallbacks.clear();
-	if ( mConnected ) {
+	if ( mConnected || mRunning ) {
 		disconnect();
 	}
-	if ( mFreqData != 0 ) {
-		delete [ ] mFreqData;
+	stopRecording();
+	mUsers.clear();
+
+}
+
+// User state constructor
+Emotiv::User::User( uint32_t userId, uint32_t sampleRate, const EmotivTaskPoolRef &taskPool )
+	: mBandPower( userId )
+{
+	mClockOffset = 0.0;
+	mClockTimestamp = 0.0;
+	mClockValid = false;
+	mLastCounter = -1;
+	mLastHopSample = 0;
+	for ( int32_t i = 0; i < EEG_CHANNEL_COUNT; i++ ) {
+		mLastRaw[ i ] = 0.0;
+	}
+	mLastSampleCount = 0;
+	mLastTimestamp = -1.0;
+	mPreprocessor = EmotivPreprocessor::create( EEG_CHANNEL_COUNT, (float)sampleRate );
+	mRawBuffer = EmotivRingBuffer::create( EEG_CHANNEL_COUNT, RAW_BUFFER_SIZE );
+	mSpectrum = EmotivSpectrum::create();
+	mSpectrum->setSampleRate( (float)sampleRate );
+	mSpectrum->setTaskPool( taskPool );
+	mAnalyzer = mSpectrum;
+	mStateValid = false;
+	mUserId = userId;
+}
+
+// Pull new raw EEG samples from the engine into the user's ring buffer
+void Emotiv::acquire( User &user )
+{
+
+	// Get number of new samples
+	double start = mTimer.getSeconds();
+	uint32_t samplesTaken = mEngine->updateData( user.mUserId );
+	if ( samplesTaken == 0 ) {
+		return;
+	}
+
+	// Size scratch buffers. They are sized to the engine's buffer 
+	// when connecting, so this only grows if the engine hands back 
+	// more than that.
+	if ( mRawData.size() < samplesTaken ) {
+		mRawData.resize( samplesTaken );
+	}
+	if ( mCounterData.size() < samplesTaken ) {
+		mCounterData.resize( samplesTaken );
+		mGapData.resize( samplesTaken );
+		mTimestampData.resize( samplesTaken );
+	}
+
+	// Find lost and repeated samples before anything is written, 
+	// so gaps can be filled in and repeats left out
+	mEngine->getData( user.mUserId, EmotivEngine::CHANNEL_COUNTER, &mCounterData[ 0 ], samplesTaken );
+	mEngine->getData( user.mUserId, EmotivEngine::CHANNEL_TIMESTAMP, &mTimestampData[ 0 ], samplesTaken );
+	uint32_t duplicateCount = 0;
+	uint32_t fillCount = findGaps( user, samplesTaken, duplicateCount );
+	uint32_t keptCount = samplesTaken - duplicateCount;
+	if ( keptCount == 0 ) {
+		mTiming.mFetch += mTimer.getSeconds() - start;
+		return;
+	}
+	uint32_t blockSize = keptCount + fillCount;
+	if ( mFillData.size() < blockSize ) {
+		mFillData.resize( blockSize );
+	}
+
+	// Drop repeated samples' timestamps so the block is stamped 
+	// from the samples actually written. Samples filled in ahead 
+	// of the first one take its place in time.
+	int32_t leadCount = mGapData[ 0 ];
+	if ( duplicateCount > 0 ) {
+		leadCount = -1;
+		uint32_t position = 0;
+		for ( uint32_t j = 0; j < samplesTaken; j++ ) {
+			if ( mGapData[ j ] != GAP_DUPLICATE ) {
+				if ( leadCount < 0 ) {
+					leadCount = mGapData[ j ];
+				}
+				mTimestampData[ position++ ] = mTimestampData[ j ];
+			}
+		}
+	}
+
+	// Copy each EEG channel into the ring buffer, interpolating 
+	// across gaps and skipping repeats, then clean it up in place 
+	// and publish the block
+	EmotivRingBuffer & rawBuffer = *user.mRawBuffer;
+	for ( int32_t i = 0; i < EEG_CHANNEL_COUNT; i++ ) {
+		mEngine->getData( user.mUserId, i, &mRawData[ 0 ], samplesTaken );
+		if ( fillCount > 0 || duplicateCount > 0 ) {
+			double previous = user.mLastRaw[ i ];
+			uint32_t position = 0;
+			for ( uint32_t j = 0; j < samplesTaken; j++ ) {
+				int32_t gap = mGapData[ j ];
+				if ( gap == GAP_DUPLICATE ) {
+					continue;
+				}
+				double step = ( mRawData[ j ] - previous ) / (double)( gap + 1 );
+				for ( int32_t k = 1; k <= gap; k++ ) {
+					mFillData[ position++ ] = previous + step * (double)k;
+				}
+				mFillData[ position++ ] = mRawData[ j ];
+				previous = mRawData[ j ];
+			}
+			rawBuffer.write( i, &mFillData[ 0 ], blockSize );
+			user.mLastRaw[ i ] = previous;
+		} else {
+			rawBuffer.write( i, &mRawData[ 0 ], samplesTaken );
+			user.mLastRaw[ i ] = mRawData[ samplesTaken - 1 ];
+		}
+	}
+	user.mPreprocessor->process( rawBuffer, blockSize );
+	rawBuffer.commit( blockSize );
+	mTiming.mFetch += mTimer.getSeconds() - start;
+	mStatSamplesAcquired.fetch_add( keptCount, boost::memory_order_relaxed );
+	if ( fillCount > 0 ) {
+		mStatSamplesInterpolated.fetch_add( fillCount, boost::memory_order_relaxed );
+	}
+
+	// Stamp the block from the headset clock
+	double time = stampBlock( user, keptCount, start ) - (double)leadCount / (double)mSampleRate;
+	publishRaw( user, blockSize, time );
+
+	// Record the new block
+	if ( mRecorder ) {
+		uint32_t count = min( blockSize, rawBuffer.getCapacity() );
+		mRecorder->recordRaw( user.mUserId, rawBuffer, rawBuffer.getWriteCount() - count, count, mTimer.getSeconds() );
+	}
+
+}
+
+// Fetch raw data for every user on the acquisition clock
+void Emotiv::acquireUsers()
+{
+
+	// Take references first so raw callbacks can look users up
+	mAcquisitionUsers.clear();
+	{
+		boost::mutex::scoped_lock lock( mUserMutex );
+		for ( map<uint32_t, UserRef>::iterator userIt = mUsers.begin(); userIt != mUsers.end(); ++userIt ) {
+			mAcquisitionUsers.push_back( userIt->second );
+		}
+	}
+
+	// Fetch each user's samples and analyze any that are new. 
+	// Callbacks may stop the thread in between.
+	for ( vector<UserRef>::iterator userIt = mAcquisitionUsers.begin(); mRunning && userIt != mAcquisitionUsers.end(); ++userIt ) {
+		User & user = **userIt;
+		uint64_t sampleCount = user.mRawBuffer->getWriteCount();
+		acquire( user );
+		if ( mRunning && user.mRawBuffer->getWriteCount() != sampleCount ) {
+			processBlock( user );
+		}
 	}
+	mAcquisitionUsers.clear();
+
+}
+
+// Add batch callback
+int32_t Emotiv::addBatchCallback( const boost::function<void ( const EmotivEvent *events, uint32_t count )> &callback )
+{
+
+	// Determine return ID
+	int32_t mCallbackID = nextCallbackId();
+
+	// Create callback and add it to the list
+	mCallbacks.insert( std::make_pair( mCallbackID, CallbackRef( new Callback( mBatchSignal.connect( callback ) ) ) ) );
+
+	// Return callback ID
+	return mCallbackID;
 
 }
 
 // Add callback
-int32_t Emotiv::addCallback( const boost::function<void ( EmotivEvent event )> &callback )
+int32_t Emotiv::addCallback( const boost::function<void ( const EmotivEvent &event )> &callback )
 {
 
 	// Determine return ID
-	int32_t mCallbackID = mCallbacks.empty() ? 0 : mCallbacks.rbegin()->first + 1;
+	int32_t mCallbackID = nextCallbackId();
 
 	// Create callback and add it to the list
 	mCallbacks.insert( std::make_pair( mCallbackID, CallbackRef( new Callback( mSignal.connect( callback ) ) ) ) );
@@ -124,45 +413,158 @@ int32_t Emotiv::addCallback( const boost::function<void ( EmotivEvent event )> &
 
 }
 
-// Connect to Emotiv Engine
-bool Emotiv::connect( const string &deviceId, const string &remoteAddress, uint16_t port )
+// Add raw callback
+int32_t Emotiv::addRawCallback( const boost::function<void ( const EmotivRawView &view )> &callback, int32_t layout )
 {
 
-	try {
+	// Determine return ID
+	int32_t mCallbackID = nextCallbackId();
 
-		// Connect to remote engine or composer or the local Emotiv Engine
-		if ( remoteAddress.length() > 0 && port > 0 ) {
-			mConnected = EE_EngineRemoteConnect( remoteAddress.c_str(), port, deviceId.c_str() ) == EDK_OK;
-		} else {
-			mConnected = EE_EngineConnect( deviceId.c_str() ) == EDK_OK;
+	// Create callback and add it to the list
+	RawSignal & signal = mRawSignals[ layout == RAW_LAYOUT_INTERLEAVED ? RAW_LAYOUT_INTERLEAVED : RAW_LAYOUT_PLANAR ];
+	mCallbacks.insert( std::make_pair( mCallbackID, CallbackRef( new Callback( signal.connect( callback ) ) ) ) );
+
+	// Return callback ID
+	return mCallbackID;
+
+}
+
+// Create state for a new user, or return the existing one
+Emotiv::UserRef Emotiv::addUser( uint32_t userId )
+{
+	boost::mutex::scoped_lock lock( mUserMutex );
+	UserRef & user = mUsers[ userId ];
+	if ( !user ) {
+		user = UserRef( new User( userId, mSampleRate, mTaskPool ) );
+		user->mPreprocessor->setDcRemoval( mDcRemoval );
+		user->mPreprocessor->setNotchFrequency( mNotchFrequency );
+		user->mSpectrum->setMode( mFftMode );
+		user->mSpectrum->setWelch( mWelchSegmentSize, mWelchSegmentCount );
+		user->mSpectrum->setWindowFunction( mFftWindowFunction );
+		selectAnalyzer( *user );
+	}
+	return user;
+}
+
+// Run the user's analyzer on samples up to "end" and store 
+// the results
+bool Emotiv::analyze( User &user, uint64_t end )
+{
+
+	// Bail if there is nothing to analyze
+	EmotivAnalyzer & analyzer = *user.mAnalyzer;
+	if ( !analyzer.process( *user.mRawBuffer, getFftWindowSize(), end ) ) {
+		return false;
+	}
+
+	// Keep per-channel results and their averages
+	mTiming.mFft += analyzer.getFftTime();
+	mTiming.mReduce += analyzer.getReduceTime();
+	mStatFftTime.store( toNanoseconds( analyzer.getFftTime() + analyzer.getReduceTime() ), boost::memory_order_relaxed );
+	boost::mutex::scoped_lock lock( mUserMutex );
+	user.mBandPower = analyzer.getBandPower();
+	user.mBandPower.mUserId = user.mUserId;
+	return true;
+
+}
+
+// Analyzes samples that arrived since the last pass, updating 
+// "event" with the results. Each completed short-time hop is 
+// dispatched with "event", and so is each streaming result when 
+// "dispatchStreaming" is set. Returns true if any event was 
+// dispatched.
+bool Emotiv::analyzeNew( User &user, EmotivEvent &event, bool dispatchStreaming )
+{
+
+	// Samples written so far
+	uint64_t sampleCount = user.mRawBuffer->getWriteCount();
+
+	// Streaming analyzers take in every block as it arrives
+	if ( user.mAnalyzer->isStreaming() ) {
+		if ( analyze( user, sampleCount ) ) {
+			setBrainwaves( user, event );
+			if ( dispatchStreaming ) {
+				dispatch( event );
+				return true;
+			}
 		}
 
-		// Connected
-		if ( mConnected ) {
+	// Short-time mode
+	} else if ( mFftHopSize > 0 ) {
 
-			// Add event listening
-			mEvent = EE_EmoEngineEventCreate();
-			mState = EE_EmoStateCreate();
+		// Skip hops whose window has already been overwritten
+		uint32_t windowSize = getFftWindowSize();
+		uint64_t firstEnd = sampleCount + windowSize > user.mRawBuffer->getCapacity() ? sampleCount + windowSize - user.mRawBuffer->getCapacity() : 0;
+		if ( user.mLastHopSample + mFftHopSize < firstEnd ) {
+			user.mLastHopSample = firstEnd - mFftHopSize;
+		}
 
-			// Set up EEG data sampler
-			mData = EE_DataCreate();
-			EE_DataSetBufferSizeInSec( (float)mSampleTime );
+		// Analyze each completed hop and send an event 
+		// with its band power
+		bool dispatched = false;
+		while ( mRunning && user.mLastHopSample + mFftHopSize <= sampleCount ) {
+			user.mLastHopSample += mFftHopSize;
+			if ( analyze( user, user.mLastHopSample ) ) {
+				setBrainwaves( user, event );
+				dispatch( event );
+				dispatched = true;
+			}
+		}
+		return dispatched;
+
+	} else if ( sampleCount - user.mLastSampleCount >= static_cast<uint64_t>( mSampleTime * (double)mSampleRate ) ) {
+
+		// Update sample count. Counting samples rather than 
+		// seconds keeps the cadence right during playback.
+		user.mLastSampleCount = sampleCount;
 
+		// Analyze the latest window
+		if ( analyze( user, sampleCount ) ) {
+			setBrainwaves( user, event );
 		}
 
-	} catch ( ... ) {
+	}
+	return false;
 
-		// Disconnect if routine fails
-		mConnected = false;
+}
 
+// Connect to Emotiv Engine
+bool Emotiv::connect( const string &deviceId, const string &remoteAddress, uint16_t port )
+{
+
+	// Connect engine. The acquisition thread leaves it alone 
+	// until it is marked connected.
+	bool connected = mEngine->connect( deviceId, remoteAddress, port );
+
+	// Reopen the event queue closed by disconnect()
+	EventQueueRef eventQueue = getEventQueue();
+	if ( eventQueue ) {
+		eventQueue->open();
 	}
 
-	// Start thread
-	mRunning = true;
-	mThread = std::shared_ptr<boost::thread>( new boost::thread( bind( &Emotiv::update, this ) ) );
+	{
+
+		// Size the engine's buffer and scratch buffers, then hand 
+		// the engine over. The thread may already be running for 
+		// playback, so this is done under the lock.
+		boost::mutex::scoped_lock lock( mMutex );
+		if ( connected ) {
+			mEngine->setDataBufferSize( mDataBufferTime );
+			reserve();
+		}
+		mConnected = connected;
+
+		// Start thread
+		if ( !mRunning ) {
+			mRunning = true;
+			mThread = std::shared_ptr<boost::thread>( new boost::thread( bind( &Emotiv::update, this ) ) );
+		}
+
+	}
 
-	// Return connected flag
-	return mConnected;
+	// Wake the thread if it is waiting for events
+	mCondition.notify_all();
+	return connected;
 
 }
 
@@ -170,58 +572,317 @@ bool Emotiv::connect( const string &deviceId, const string &remoteAddress, uint1
 bool Emotiv::disconnect()
 {
 
-	// Stop thread
+	// Release the thread if it is blocked on a full queue
+	EventQueueRef eventQueue = getEventQueue();
+	if ( eventQueue ) {
+		eventQueue->close();
+	}
+
+	// Stop thread, waking it if it is waiting for events
 	if ( mRunning ) {
-		mRunning = false;
+		{
+			boost::mutex::scoped_lock lock( mMutex );
+			mRunning = false;
+		}
+		mCondition.notify_all();
 		mThread->join();
 	}
 
-	// Disconnect and free resources
-	try {
-		if ( EE_EngineDisconnect() != EDK_OK ) {
-			return false;
-		}
-		EE_EmoStateFree( mState );
-		EE_EmoEngineEventFree( mEvent );
-		EE_DataFree( mData );
-		mConnected = false;
+	// Stop playback
+	mPlayer.reset();
+
+	// Disconnect engine
+	if ( !mConnected ) {
 		return true;
-	} catch ( ... ) {
+	}
+	if ( !mEngine->disconnect() ) {
 		return false;
 	}
+	mConnected = false;
+	return true;
 
 }
 
 // Get number of connected devices
 int32_t Emotiv::getNumUsers()
 {
+	return mConnected ? mEngine->getNumUsers() : 0;
+}
 
-	// Retrieve and return number of connected headsets
-	uint32_t users = 0;
-	EE_EngineGetNumUser( &users );
-	return users;
-
+// Add an event to a batch, sending the batch if it is full. A new 
+// batch size takes effect here, on the thread that owns the batch.
+void Emotiv::collect( vector<EmotivEvent> &batch, const EmotivEvent &event )
+{
+	if ( mBatchSignal.empty() ) {
+		return;
+	}
+	uint32_t batchSize = mBatchSize.load( boost::memory_order_relaxed );
+	if ( batch.capacity() < batchSize ) {
+		batch.reserve( batchSize );
+	}
+	batch.push_back( event );
+	if ( batch.size() >= batchSize ) {
+		flush( batch );
+	}
 }
 
-// Load profile onto device
-bool Emotiv::loadProfile( const fs::path &profilePath, uint32_t userId )
+// Send event to callbacks, or queue it for poll()
+void Emotiv::dispatch( const EmotivEvent &event )
 {
+	if ( mRecorder ) {
+		mRecorder->record( EmotivRecorder::RECORD_EVENT, &event, sizeof( EmotivEvent ), mTimer.getSeconds() );
+	}
+	double start = mTimer.getSeconds();
+	if ( mDispatchMode == DISPATCH_QUEUED && mEventQueue ) {
+
+		// A full BLOCK queue waits with mMutex released, so the 
+		// thread calling poll() can still use the rest of the API. 
+		// The queue may be swapped while we wait, so hold on to it.
+		EventQueueRef eventQueue = mEventQueue;
+		eventQueue->push( event, &mMutex );
+		mStatQueueDepth.store( eventQueue->getDepth(), boost::memory_order_relaxed );
+
+	} else {
+
+		// Run callbacks without mMutex so they may call back in. 
+		// Only this thread touches the batch.
+		EmotivScopedUnlock unlock( mMutex );
+		mSignal( event );
+		collect( mBatch, event );
 
-	// Bail if not connected
-	if ( !mConnected ) {
-		return false;
 	}
+	mStatCallbackTime.store( toNanoseconds( mTimer.getSeconds() - start ), boost::memory_order_relaxed );
+
+	// Keep this event's timing. Further events from the same 
+	// state only count their own analysis.
+	if ( mTimingQueue ) {
+		mTiming.mDispatch = mTimer.getSeconds() - start;
+		mTiming.mLatency = start - mEventTime;
+		mTimingQueue->push( mTiming );
+	}
+	startTiming( mEventTime );
+}
 
-	// Load profile
-	try {
-		if ( EE_LoadUserProfile( userId, profilePath.generic_string().c_str() ) != EDK_OK ) {
-			return false;
+// Finds samples lost before each new one from the packet counter, 
+// using the timestamps to count whole laps of the counter. Returns 
+// the number of samples to fill in, stored per sample in "mGapData". 
+// Repeated samples are marked GAP_DUPLICATE there and counted in 
+// "duplicates".
+uint32_t Emotiv::findGaps( User &user, uint32_t count, uint32_t &duplicates )
+{
+	duplicates = 0;
+	uint32_t fillCount = 0;
+	uint64_t gapCount = 0;
+	uint64_t samplesLost = 0;
+	uint64_t wraps = 0;
+	for ( uint32_t i = 0; i < count; i++ ) {
+		mGapData[ i ] = 0;
+		int32_t counter = static_cast<int32_t>( mCounterData[ i ] );
+		double timestamp = mTimestampData[ i ];
+		if ( counter < 0 || counter >= EmotivEngine::COUNTER_RANGE ) {
+			continue;
 		}
-		return true;
-	} catch ( ... ) {
-		return false;
+		if ( user.mLastCounter >= 0 ) {
+
+			// Samples the timestamps say went by since the last one
+			double elapsed = 0.0;
+			if ( user.mLastTimestamp >= 0.0 && timestamp > user.mLastTimestamp ) {
+				elapsed = ( timestamp - user.mLastTimestamp ) * (double)mSampleRate - 1.0;
+			}
+
+			// A repeated counter is the same sample sent twice, 
+			// unless the timestamps show a whole lap went by
+			if ( counter == user.mLastCounter && elapsed < (double)EmotivEngine::COUNTER_RANGE * 0.5 ) {
+				mGapData[ i ] = GAP_DUPLICATE;
+				duplicates++;
+				user.mLastTimestamp = max( user.mLastTimestamp, timestamp );
+				continue;
+			}
+
+			// The counter alone can't tell a gap from one that is 
+			// longer by whole laps
+			int32_t missing = ( counter - user.mLastCounter - 1 + EmotivEngine::COUNTER_RANGE ) % EmotivEngine::COUNTER_RANGE;
+			int32_t laps = 0;
+			if ( elapsed > 0.0 ) {
+				laps = max( static_cast<int32_t>( floor( ( elapsed - (double)missing ) / (double)EmotivEngine::COUNTER_RANGE + 0.5 ) ), 0 );
+				missing += laps * EmotivEngine::COUNTER_RANGE;
+			}
+			wraps += ( user.mLastCounter + missing + 1 ) / EmotivEngine::COUNTER_RANGE;
+
+			// Count the gap, keeping short ones to fill
+			if ( missing > 0 ) {
+				gapCount++;
+				samplesLost += missing;
+				if ( mGapFill && static_cast<uint32_t>( missing ) <= mMaxGapFill ) {
+					mGapData[ i ] = missing;
+					fillCount += missing;
+				}
+			}
+
+		}
+		user.mLastCounter = counter;
+		user.mLastTimestamp = timestamp;
+	}
+	if ( gapCount > 0 ) {
+		mStatGapCount.fetch_add( gapCount, boost::memory_order_relaxed );
+		mStatSamplesLost.fetch_add( samplesLost, boost::memory_order_relaxed );
+	}
+	if ( wraps > 0 ) {
+		mStatCounterWraps.fetch_add( wraps, boost::memory_order_relaxed );
+	}
+	if ( duplicates > 0 ) {
+		mStatSamplesDuplicated.fetch_add( duplicates, boost::memory_order_relaxed );
+	}
+	return fillCount;
+}
+
+// Send a batch to batch callbacks and empty it
+void Emotiv::flush( vector<EmotivEvent> &batch )
+{
+	if ( !batch.empty() ) {
+		mBatchSignal( &batch[ 0 ], static_cast<uint32_t>( batch.size() ) );
+		batch.clear();
+	}
+}
+
+// Get average heap allocations per event
+double Emotiv::getAllocationsPerEvent()
+{
+	boost::mutex::scoped_lock lock( mMutex );
+	return mEventCount > 0 ? (double)mEventAllocationCount / (double)mEventCount : 0.0;
+}
+
+// Get latest band power for a user
+EmotivBandPower Emotiv::getBandPower( uint32_t userId )
+{
+	boost::mutex::scoped_lock lock( mUserMutex );
+	map<uint32_t, UserRef>::iterator userIt = mUsers.find( userId );
+	return userIt == mUsers.end() ? EmotivBandPower( userId ) : userIt->second->mBandPower;
+}
+
+// Get band envelope buffer for a user
+EmotivRingBufferRef Emotiv::getEnvelopeBuffer( uint32_t userId )
+{
+	boost::mutex::scoped_lock lock( mUserMutex );
+	map<uint32_t, UserRef>::iterator userIt = mUsers.find( userId );
+	if ( userIt == mUsers.end() || !userIt->second->mFilterBank ) {
+		return EmotivRingBufferRef();
+	}
+	return userIt->second->mFilterBank->getEnvelopeBuffer();
+}
+
+// Get event queue
+Emotiv::EventQueueRef Emotiv::getEventQueue()
+{
+	boost::mutex::scoped_lock lock( mEventQueueMutex );
+	return mEventQueue;
+}
+
+// Get FFT window size in samples
+uint32_t Emotiv::getFftWindowSize()
+{
+	if ( mFftWindowSize > 0 ) {
+		return mFftWindowSize;
+	}
+	return static_cast<uint32_t>( mSampleTime * (double)mSampleRate );
+}
+
+// Get number of queued events
+uint32_t Emotiv::getQueueDepth()
+{
+	EventQueueRef eventQueue = getEventQueue();
+	return eventQueue ? eventQueue->getDepth() : 0;
+}
+
+// Get number of queue overflows
+uint64_t Emotiv::getQueueOverflowCount()
+{
+	EventQueueRef eventQueue = getEventQueue();
+	return eventQueue ? eventQueue->getOverflowCount() : 0;
+}
+
+// Get number of records dropped by the recorder
+uint64_t Emotiv::getRecordingDropCount()
+{
+	boost::mutex::scoped_lock lock( mMutex );
+	return mRecorder ? mRecorder->getDropCount() : 0;
+}
+
+// Get raw EEG buffer for a user
+EmotivRingBufferRef Emotiv::getRawBuffer( uint32_t userId )
+{
+	boost::mutex::scoped_lock lock( mUserMutex );
+	map<uint32_t, UserRef>::iterator userIt = mUsers.find( userId );
+	return userIt == mUsers.end() ? EmotivRingBufferRef() : userIt->second->mRawBuffer;
+}
+
+// Get number of DSP worker threads
+uint32_t Emotiv::getThreadCount()
+{
+	boost::mutex::scoped_lock lock( mMutex );
+	return mTaskPool ? mTaskPool->getNumThreads() : 0;
+}
+
+// Get profiled event timings
+uint32_t Emotiv::getTimings( vector<EmotivTiming> &timings )
+{
+
+	// Take queue
+	TimingQueueRef timingQueue;
+	{
+		boost::mutex::scoped_lock lock( mMutex );
+		timingQueue = mTimingQueue;
 	}
+	if ( !timingQueue ) {
+		return 0;
+	}
+
+	// Move timings out
+	uint32_t count = 0;
+	EmotivTiming timing;
+	while ( timingQueue->pop( timing ) ) {
+		timings.push_back( timing );
+		count++;
+	}
+	return count;
+
+}
 
+// Get runtime counters
+EmotivStats Emotiv::getStats()
+{
+	EmotivStats stats;
+	stats.mEventCount = 0;
+	for ( int32_t i = 0; i < EmotivEngine::EVENT_TYPE_COUNT; i++ ) {
+		stats.mEventCount += mStatEventCounts[ i ].load( boost::memory_order_relaxed );
+		stats.mEventsPerSecond[ i ] = (double)mStatEventRates[ i ].load( boost::memory_order_relaxed ) / 1000.0;
+	}
+	stats.mAcquisitionLatency = (double)mStatAcquisitionLatency.load( boost::memory_order_relaxed ) / 1000000000.0;
+	stats.mCallbackTime = (double)mStatCallbackTime.load( boost::memory_order_relaxed ) / 1000000000.0;
+	stats.mCounterWraps = mStatCounterWraps.load( boost::memory_order_relaxed );
+	stats.mFftTime = (double)mStatFftTime.load( boost::memory_order_relaxed ) / 1000000000.0;
+	stats.mGapCount = mStatGapCount.load( boost::memory_order_relaxed );
+	stats.mLoopIterationsPerEvent = stats.mEventCount > 0 ? (double)mStatLoopIterations.load( boost::memory_order_relaxed ) / (double)stats.mEventCount : 0.0;
+	stats.mQueueDepth = mStatQueueDepth.load( boost::memory_order_relaxed );
+	stats.mSamplesAcquired = mStatSamplesAcquired.load( boost::memory_order_relaxed );
+	stats.mSamplesDuplicated = mStatSamplesDuplicated.load( boost::memory_order_relaxed );
+	stats.mSamplesInterpolated = mStatSamplesInterpolated.load( boost::memory_order_relaxed );
+	stats.mSamplesLost = mStatSamplesLost.load( boost::memory_order_relaxed );
+	return stats;
+}
+
+// Get state of a user
+Emotiv::UserRef Emotiv::getUser( uint32_t userId )
+{
+	boost::mutex::scoped_lock lock( mUserMutex );
+	map<uint32_t, UserRef>::iterator userIt = mUsers.find( userId );
+	return userIt == mUsers.end() ? UserRef() : userIt->second;
+}
+
+// Load profile onto device
+bool Emotiv::loadProfile( const fs::path &profilePath, uint32_t userId )
+{
+	return mConnected && mEngine->loadProfile( profilePath, userId );
 }
 
 // List profiles
@@ -246,202 +907,838 @@ map<fs::path, string> Emotiv::listProfiles( const fs::path &dataPath )
 
 }
 
+// Get an unused callback ID
+int32_t Emotiv::nextCallbackId()
+{
+	return mCallbacks.empty() ? 0 : mCallbacks.rbegin()->first + 1;
+}
+
+// Play recorded session
+bool Emotiv::play( const fs::path &path, float speed )
+{
+
+	// Finish any previous playback
+	stopPlayback();
+
+	// Map file
+	EmotivPlayerRef player = EmotivPlayer::create( path );
+	if ( !player || player->getHeader().mEventSize != sizeof( EmotivEvent ) || 
+		player->getHeader().mChannelCount != EEG_CHANNEL_COUNT ) {
+		return false;
+	}
+
+	{
+
+		// Hand it to the acquisition thread
+		boost::mutex::scoped_lock lock( mMutex );
+		mPlayer = player;
+		mPlaybackEventTime = -1.0f;
+		mPlaybackSpeed = max( speed, 0.0f );
+		mPlaybackStartTime = mTimer.getSeconds();
+		mPlaybackUserId = 0;
+		if ( player->getHeader().mSampleRate > 0 ) {
+			setSampleRate( player->getHeader().mSampleRate );
+		}
+
+		// Start thread
+		if ( !mRunning ) {
+			mRunning = true;
+			mThread = std::shared_ptr<boost::thread>( new boost::thread( bind( &Emotiv::update, this ) ) );
+		}
+
+	}
+
+	// Wake the thread if it is waiting for events
+	mCondition.notify_all();
+	return true;
+
+}
+
+// Check if playing
+bool Emotiv::playing()
+{
+	boost::mutex::scoped_lock lock( mMutex );
+	return mPlayer != 0;
+}
+
+// Dispatch queued events on this thread
+uint32_t Emotiv::poll( uint32_t maxEvents )
+{
+
+	// Bail if not queueing
+	EventQueueRef eventQueue = getEventQueue();
+	if ( !eventQueue ) {
+		return 0;
+	}
+
+	// Take the queued events under the lock, borrowing the storage 
+	// kept from the last call so polling doesn't allocate
+	vector<EmotivEvent> events;
+	{
+		boost::mutex::scoped_lock lock( mPollMutex );
+		events.swap( mPollEvents );
+	}
+	EmotivEvent event;
+	while ( ( maxEvents == 0 || events.size() < maxEvents ) && eventQueue->pop( event ) ) {
+		events.push_back( event );
+	}
+	mStatQueueDepth.store( eventQueue->getDepth(), boost::memory_order_relaxed );
+
+	// Run callbacks without any lock held, so they may call back 
+	// in. Batches are sent straight from the array, in runs of the 
+	// batch size.
+	uint32_t count = static_cast<uint32_t>( events.size() );
+	uint32_t batchStart = 0;
+	for ( uint32_t i = 0; i < count; i++ ) {
+		mSignal( events[ i ] );
+		if ( i + 1 - batchStart >= mBatchSize.load( boost::memory_order_relaxed ) ) {
+			mBatchSignal( &events[ batchStart ], i + 1 - batchStart );
+			batchStart = i + 1;
+		}
+	}
+	if ( batchStart < count ) {
+		mBatchSignal( &events[ batchStart ], count - batchStart );
+	}
+
+	// Hand the storage back
+	events.clear();
+	boost::mutex::scoped_lock lock( mPollMutex );
+	if ( events.capacity() > mPollEvents.capacity() ) {
+		events.swap( mPollEvents );
+	}
+	return count;
+
+}
+
+// Reads and handles the next engine event, returns false if there is none
+bool Emotiv::processEvent()
+{
+
+	// Get event
+	uint32_t userId = 0;
+	EmotivEvent event;
+	double start = mTimer.getSeconds();
+	int32_t eventType = mEngine->getNextEvent( userId, event );
+	if ( eventType == EmotivEngine::EVENT_NONE ) {
+		return false;
+	}
+	startTiming( start );
+	mTiming.mDecode = mTimer.getSeconds() - start;
+	if ( eventType < EmotivEngine::EVENT_TYPE_COUNT ) {
+		mStatEventCounts[ eventType ].fetch_add( 1, boost::memory_order_relaxed );
+	}
+
+	// Enable data acquisition for new users and give 
+	// them a raw buffer
+	if ( eventType == EmotivEngine::EVENT_USER_ADDED ) {
+		uint32_t sampleRate = mEngine->enableData( userId );
+		if ( sampleRate > 0 ) {
+			setSampleRate( sampleRate );
+		}
+		addUser( userId );
+	}
+
+	// Release state when user leaves
+	if ( eventType == EmotivEngine::EVENT_USER_REMOVED ) {
+		mEngine->disableData( userId );
+		removeUser( userId );
+	}
+
+	// Status update. Keep raw buffer current, then analyze 
+	// and dispatch.
+	if ( eventType == EmotivEngine::EVENT_STATE_UPDATED ) {
+		UserRef user = getUser( userId );
+		if ( user ) {
+			setBrainwaves( *user, event );
+			if ( mAcquisitionInterval <= 0.0 ) {
+				acquire( *user );
+				processState( *user, event );
+			} else {
+
+				// Samples are analyzed on the acquisition clock, 
+				// so keep the state for its results and send it 
+				// with the latest band power
+				user->mLastState = event;
+				user->mStateValid = true;
+				dispatch( event );
+
+			}
+		} else {
+			dispatch( event );
+		}
+	}
+
+	// Event handled
+	return true;
+
+}
+
+// Plays the next recorded record if it is due. Returns false if 
+// there is none, setting "wait" to the time until the next one.
+bool Emotiv::processRecord( double &wait )
+{
+
+	// Stop at the end of the file. The player is held here, since 
+	// callbacks may stop playback while its records are in use.
+	EmotivPlayerRef player = mPlayer;
+	const EmotivRecorder::RecordHeader * record = player->peek();
+	if ( record == 0 ) {
+		mPlayer.reset();
+		return false;
+	}
+
+	// Wait for the record's time at the playback speed
+	if ( mPlaybackSpeed > 0.0f ) {
+		double due = mPlaybackStartTime + record->mTime / (double)mPlaybackSpeed;
+		double now = mTimer.getSeconds();
+		if ( now < due ) {
+			wait = min( wait, due - now );
+			return false;
+		}
+	}
+	const char * payload = 0;
+	startTiming( mTimer.getSeconds() );
+	player->next( payload );
+
+	// Raw samples go into the user's ring buffer as if acquired
+	if ( record->mType == EmotivRecorder::RECORD_RAW && record->mSize >= sizeof( EmotivRecorder::RawBlock ) ) {
+		EmotivRecorder::RawBlock block;
+		memcpy( &block, payload, sizeof( EmotivRecorder::RawBlock ) );
+		if ( block.mSampleCount > 0 && block.mChannelCount == EEG_CHANNEL_COUNT && 
+			record->mSize == sizeof( EmotivRecorder::RawBlock ) + block.mChannelCount * block.mSampleCount * sizeof( float ) ) {
+			UserRef user = addUser( block.mUserId );
+			EmotivRingBuffer & rawBuffer = *user->mRawBuffer;
+			const float * samples = reinterpret_cast<const float *>( payload + sizeof( EmotivRecorder::RawBlock ) );
+			uint32_t count = min( block.mSampleCount, rawBuffer.getCapacity() );
+			uint32_t skip = block.mSampleCount - count;
+			for ( int32_t i = 0; i < EEG_CHANNEL_COUNT; i++ ) {
+				rawBuffer.write( i, samples + i * block.mSampleCount + skip, count );
+			}
+			rawBuffer.commit( count );
+			publishRaw( *user, count, mTimer.getSeconds() - (double)count / (double)mSampleRate );
+		}
+	}
+
+	// Events are analyzed and dispatched as if they just arrived. 
+	// Short-time mode records one event per hop with the same state, 
+	// so only the first of those is replayed.
+	if ( record->mType == EmotivRecorder::RECORD_EVENT && record->mSize == sizeof( EmotivEvent ) ) {
+		EmotivEvent event;
+		memcpy( static_cast<void *>( &event ), payload, sizeof( EmotivEvent ) );
+		mTiming.mDecode = mTimer.getSeconds() - mEventTime;
+		if ( event.mTime != mPlaybackEventTime || event.mUserId != mPlaybackUserId ) {
+			mPlaybackEventTime = event.mTime;
+			mPlaybackUserId = event.mUserId;
+			UserRef user = addUser( event.mUserId );
+			setBrainwaves( *user, event );
+			processState( *user, event );
+		}
+	}
+
+	// Record handled
+	return true;
+
+}
+
+// Analyzes a block fetched on the acquisition clock, dispatching 
+// the user's latest state with each streaming result or hop. 
+// Analysis waits for the user's first state, since there is 
+// nothing to send the results with before it.
+void Emotiv::processBlock( User &user )
+{
+	if ( mFftEnabled && user.mStateValid ) {
+		startTiming( mTimer.getSeconds() );
+		analyzeNew( user, user.mLastState, true );
+	}
+}
+
+// Runs analysis on a user's raw buffer and dispatches events for a new state
+void Emotiv::processState( User &user, EmotivEvent &event )
+{
+
+	// The last hop event already carried this state
+	if ( mFftEnabled && analyzeNew( user, event, false ) ) {
+		return;
+	}
+
+	// Dispatch event
+	dispatch( event );
+
+}
+
+// Check if profiling
+bool Emotiv::profiling()
+{
+	boost::mutex::scoped_lock lock( mMutex );
+	return mTimingQueue != 0;
+}
+
+// Hand a new block of raw samples to raw callbacks
+void Emotiv::publishRaw( const User &user, uint32_t count, double time )
+{
+
+	// Bail if nobody is listening
+	RawSignal & planarSignal = mRawSignals[ RAW_LAYOUT_PLANAR ];
+	RawSignal & interleavedSignal = mRawSignals[ RAW_LAYOUT_INTERLEAVED ];
+	if ( count == 0 || ( planarSignal.empty() && interleavedSignal.empty() ) ) {
+		return;
+	}
+	const EmotivRingBuffer & rawBuffer = *user.mRawBuffer;
+	count = min( count, rawBuffer.getCapacity() );
+	uint64_t first = rawBuffer.getWriteCount() - count;
+	double sampleRate = (double)mSampleRate;
+	EmotivRawView view;
+	view.mNumChannels = EEG_CHANNEL_COUNT;
+	view.mTime = time;
+	view.mUserId = user.mUserId;
+
+	// Planar views point into the ring, one per contiguous run
+	if ( !planarSignal.empty() ) {
+		view.mChannelStride = rawBuffer.getCapacity();
+		view.mSampleStride = 1;
+		for ( uint64_t sample = first; sample < first + count; sample += view.mSampleCount ) {
+			view.mSampleCount = static_cast<uint32_t>( first + count - sample );
+			view.mData = rawBuffer.getRun( sample, view.mSampleCount );
+			if ( view.mData == 0 ) {
+				break;
+			}
+			view.mFirstSample = sample;
+			view.mTime = time + (double)( sample - first ) / sampleRate;
+
+			// Run callbacks without mMutex so they may call back in. 
+			// Only this thread writes the ring.
+			EmotivScopedUnlock unlock( mMutex );
+			planarSignal( view );
+		}
+	}
+
+	// Interleaved subscribers share one transposed copy
+	if ( !interleavedSignal.empty() ) {
+		if ( mInterleavedData.size() < count * EEG_CHANNEL_COUNT ) {
+			mInterleavedData.resize( count * EEG_CHANNEL_COUNT );
+		}
+		uint32_t offset = 0;
+		while ( offset < count ) {
+			uint32_t runCount = count - offset;
+			const float * run = rawBuffer.getRun( first + offset, runCount );
+			if ( run == 0 ) {
+				return;
+			}
+			for ( int32_t channel = 0; channel < EEG_CHANNEL_COUNT; channel++ ) {
+				const float * input = run + channel * rawBuffer.getCapacity();
+				float * output = &mInterleavedData[ offset * EEG_CHANNEL_COUNT + channel ];
+				for ( uint32_t i = 0; i < runCount; i++ ) {
+					output[ i * EEG_CHANNEL_COUNT ] = input[ i ];
+				}
+			}
+			offset += runCount;
+		}
+		view.mChannelStride = 1;
+		view.mData = &mInterleavedData[ 0 ];
+		view.mFirstSample = first;
+		view.mSampleCount = count;
+		view.mSampleStride = EEG_CHANNEL_COUNT;
+		view.mTime = time;
+		EmotivScopedUnlock unlock( mMutex );
+		interleavedSignal( view );
+	}
+
+}
+
+// Check if recording
+bool Emotiv::recording()
+{
+	boost::mutex::scoped_lock lock( mMutex );
+	return mRecorder != 0;
+}
+
+// Size scratch buffers to hold everything the engine can buffer
+void Emotiv::reserve()
+{
+	size_t sampleCount = static_cast<size_t>( ceil( max( mDataBufferTime, mSampleTime ) * (double)mSampleRate ) ) + 1;
+	if ( mRawData.size() < sampleCount ) {
+		mRawData.resize( sampleCount );
+	}
+	if ( mCounterData.size() < sampleCount ) {
+		mCounterData.resize( sampleCount );
+		mGapData.resize( sampleCount );
+		mTimestampData.resize( sampleCount );
+	}
+	if ( mFillData.size() < sampleCount + mMaxGapFill ) {
+		mFillData.resize( sampleCount + mMaxGapFill );
+	}
+
+	// The interleaved copy is left to publishRaw(), since raw 
+	// callbacks read it without the lock held
+}
+
 // Removes callback
 void Emotiv::removeCallback( int32_t callbackID ) 
 {
 
-	// Check if we have callbacks
-	if ( mCallbacks.size() > 0 ) {
+	// Find callback. Unknown or already removed IDs are ignored.
+	CallbackList::iterator callbackIt = mCallbacks.find( callbackID );
+	if ( callbackIt != mCallbacks.end() ) {
 
 		// Disconnect the callback from the signal
-		mCallbacks.find( callbackID )->second->disconnect();
+		callbackIt->second->disconnect();
 
 		// Remove the callback from the list
-		mCallbacks.erase( callbackID ); 
+		mCallbacks.erase( callbackIt ); 
 
 	}
 
 }
 
-// Main loop
-void Emotiv::update()
+// Release a user's state. Readers holding a reference keep 
+// the raw buffer alive.
+void Emotiv::removeUser( uint32_t userId )
+{
+	boost::mutex::scoped_lock lock( mUserMutex );
+	mUsers.erase( userId );
+}
+
+// Point a user at the selected analyzer, creating it if needed
+void Emotiv::selectAnalyzer( User &user )
+{
+	if ( mAnalyzerType == ANALYZER_FILTER_BANK ) {
+		if ( !user.mFilterBank ) {
+			user.mFilterBank = EmotivFilterBank::create( user.mRawBuffer->getCapacity() );
+			user.mFilterBank->setSampleRate( user.mSpectrum->getSampleRate() );
+			user.mFilterBank->setTaskPool( mTaskPool );
+		}
+		user.mAnalyzer = user.mFilterBank;
+	} else if ( mAnalyzerType == ANALYZER_GOERTZEL ) {
+		if ( !user.mGoertzel ) {
+			user.mGoertzel = EmotivGoertzel::create();
+			user.mGoertzel->setSampleRate( user.mSpectrum->getSampleRate() );
+			user.mGoertzel->setTaskPool( mTaskPool );
+			for ( vector<float>::const_iterator targetIt = mGoertzelTargets.begin(); targetIt != mGoertzelTargets.end(); ++targetIt ) {
+				user.mGoertzel->addTarget( *targetIt );
+			}
+		}
+		user.mAnalyzer = user.mGoertzel;
+	} else if ( mAnalyzerType == ANALYZER_WAVELET ) {
+		if ( !user.mWavelet ) {
+			user.mWavelet = EmotivWavelet::create();
+			user.mWavelet->setSampleRate( user.mSpectrum->getSampleRate() );
+			user.mWavelet->setTaskPool( mTaskPool );
+		}
+		user.mAnalyzer = user.mWavelet;
+	} else {
+		user.mAnalyzer = user.mSpectrum;
+	}
+}
+
+// Set raw data cadence
+void Emotiv::setAcquisitionInterval( double interval, double bufferTime )
 {
 
-	// Lock scope
+	// Buffer enough for a few late ticks, or one FFT window 
+	// when fetching with EmoStates
 	boost::mutex::scoped_lock lock( mMutex );
+	mAcquisitionInterval = max( interval, 0.0 );
+	if ( mAcquisitionInterval > 0.0 ) {
+		mDataBufferTime = bufferTime > 0.0 ? bufferTime : mAcquisitionInterval * 4.0;
+	} else {
+		mDataBufferTime = bufferTime > 0.0 ? bufferTime : mSampleTime;
+	}
+	mNextAcquisitionTime = 0.0;
 
-	// Check running flag
-	while ( mRunning ) {
+	// Resize the engine's buffer now if it is running. The 
+	// acquisition thread is held off by the lock.
+	if ( mConnected ) {
+		mEngine->setDataBufferSize( mDataBufferTime );
+	}
+	reserve();
 
-		// Check connection
-		if ( mConnected ) {
+}
 
-			// Get event
-			int32_t eventId = EDK_NO_EVENT;
-			try {
-				eventId = EE_EngineGetNextEvent( mEvent );
-			} catch ( ... ) {
-			}
+// Select band power analyzer
+void Emotiv::setAnalyzer( int32_t analyzer )
+{
+	boost::mutex::scoped_lock lock( mMutex );
+	mAnalyzerType = analyzer;
+	boost::mutex::scoped_lock userLock( mUserMutex );
+	for ( map<uint32_t, UserRef>::iterator userIt = mUsers.begin(); userIt != mUsers.end(); ++userIt ) {
+		selectAnalyzer( *userIt->second );
+	}
+}
 
-			// Verify event
-			if ( eventId == EDK_OK ) {
-
-				// Get user ID
-				uint32_t userId;
-				if ( EE_EmoEngineEventGetUserId( mEvent, &userId ) == EDK_OK ) {
-
-					// Get event type
-					EE_Event_t eventType = EE_EmoEngineEventGetType( mEvent );
-
-					// Enable data acquisition for new users
-					if ( eventType == EE_UserAdded ) {
-						EE_DataAcquisitionEnable( userId, true);
-					}
-
-					// Status update
-					if ( eventType == EE_EmoStateUpdated ) {
-
-						// Get Emotiv state
-						EE_EmoEngineEventGetEmoState( mEvent, mState );
-						if ( mState != 0 ) {
-
-							// Create map of Expresiv Suite results
-							std::map<EE_ExpressivAlgo_t, float> expressivStates;
-							EE_ExpressivAlgo_t upperFaceAction = ES_ExpressivGetUpperFaceAction( mState );
-							float upperFacePower = ES_ExpressivGetUpperFaceActionPower( mState );
-							EE_ExpressivAlgo_t lowerFaceAction = ES_ExpressivGetLowerFaceAction( mState );
-							float lowerFacePower = ES_ExpressivGetLowerFaceActionPower( mState );
-							expressivStates[ upperFaceAction ] = upperFacePower;
-							expressivStates[ lowerFaceAction ] = lowerFacePower;
-
-							// FFT analysis enabled and data has been sampled
-							if ( mFftEnabled && getElapsedSeconds() - mLastSampleTime >= mSampleTime ) {
-
-								// Reset brainwave frequencies
-								mAlpha = 0.0f;
-								mBeta = 0.0f;
-								mDelta = 0.0f;
-								mGamma = 0.0f;
-								mTheta = 0.0f;
-
-								// Update sample time
-								mLastSampleTime = getElapsedSeconds();
-
-								// Get raw EEG data
-								EE_DataUpdateHandle( userId, mData );
-								uint32_t samplesTaken = 0;
-								EE_DataGetNumberOfSample( mData, &samplesTaken );
-								if ( samplesTaken != 0 ) {
-
-									// Create buffers for raw and target data
-									float * channelData = new float[ samplesTaken ];
-									double * data = new double[ samplesTaken ];
-
-									// Iterate through channels
-									for ( uint32_t i = 0; i < sizeof( mTargetChannelList ) / sizeof( EE_DataChannel_t ); i++ ) {
-
-										// Get channel data and record as float
-										EE_DataGet( mData, mTargetChannelList[ i ], data, samplesTaken );
-										channelData[ i ] = static_cast<float>( data[ i ] );
-										
-									}
-
-									// Clean up data
-									delete [ ] data;
-
-									// Get FFT data
-									mFft->setDataSize( samplesTaken );
-									mFft->setData( channelData );
-									mFreqData = mFft->getAmplitude();
-
-									// Clean up
-									delete [ ] channelData;
-
-									// Need at least thirty windows
-									int32_t dataSize = mFft->getBinSize();
-									if ( dataSize > 30 ) {
-
-										// Delta
-										for ( uint32_t i = 0; i < 4; i++ ) {
-											mDelta += mFreqData[ i ];
-										}
-										mDelta *= 0.25f;
-
-										// Theta
-										for ( uint32_t i = 4; i < 8; i++ ) {
-											mTheta += mFreqData[ i ];
-										}
-										mTheta *= 0.25f;
-
-										// Alpha
-										for ( uint32_t i = 8; i <= 13; i++ ) {
-											mAlpha += mFreqData[ i ];
-										}
-										mAlpha *= 0.1666667f;
-
-										// Beta
-										for ( uint32_t i = 14; i < 30; i++ ) {
-											mBeta += mFreqData[ i ];
-										}
-										mBeta *= 0.1666667f;
-
-										// Gamma
-										for ( uint32_t i = 30; i < samplesTaken; i++ ) {
-											mGamma += mFreqData[ i ];
-										}
-										mGamma /= (float)( samplesTaken - 30 );
-
-									}
-
-								}
-
-							}
-
-							// Dispatch event
-							mSignal( EmotivEvent(
-								ES_GetTimeFromStart( mState ), 
-								userId, 
-								ES_GetWirelessSignalStatus( mState ), 
-								ES_ExpressivIsBlink( mState ), 
-								ES_ExpressivIsLeftWink( mState ), 
-								ES_ExpressivIsRightWink( mState ), 
-								ES_ExpressivIsLookingLeft( mState ), 
-								ES_ExpressivIsLookingRight( mState ), 
-								expressivStates[ EXP_EYEBROW ], 
-								expressivStates[ EXP_FURROW ], 
-								expressivStates[ EXP_SMILE ], 
-								expressivStates[ EXP_CLENCH ], 
-								expressivStates[ EXP_SMIRK_LEFT ], 
-								expressivStates[ EXP_SMIRK_RIGHT ], 
-								expressivStates[ EXP_LAUGH ], 
-								ES_AffectivGetExcitementShortTermScore( mState ), 
-								ES_AffectivGetExcitementLongTermScore( mState ), 
-								ES_AffectivGetEngagementBoredomScore( mState ), 
-								ES_CognitivGetCurrentAction( mState ), 
-								ES_CognitivGetCurrentActionPower( mState ), 
-								mAlpha, 
-								mBeta, 
-								mDelta, 
-								mGamma, 
-								mTheta
-								) );
-
-							// Clean up
-							expressivStates.clear();
-
-						}
-
-					}
+// Set batch size
+void Emotiv::setBatchSize( uint32_t batchSize )
+{
 
-				}
+	// Batches are sent and resized by the thread that collects 
+	// them, from the next event on
+	mBatchSize = max<uint32_t>( batchSize, 1 );
+
+}
+
+// Copy a user's latest brainwave values into an event
+void Emotiv::setBrainwaves( const User &user, EmotivEvent &event )
+{
+	event.mAlpha = user.mBandPower.getAverage( EmotivBandPower::ALPHA );
+	event.mBeta = user.mBandPower.getAverage( EmotivBandPower::BETA );
+	event.mDelta = user.mBandPower.getAverage( EmotivBandPower::DELTA );
+	event.mGamma = user.mBandPower.getAverage( EmotivBandPower::GAMMA );
+	event.mTheta = user.mBandPower.getAverage( EmotivBandPower::THETA );
+}
+
+// Reset allocation counters
+void Emotiv::resetAllocationCount()
+{
+	boost::mutex::scoped_lock lock( mMutex );
+	mEventAllocationCount = 0;
+	mEventCount = 0;
+}
 
+// Turn DC removal on or off
+void Emotiv::setDcRemoval( bool enabled )
+{
+	boost::mutex::scoped_lock lock( mMutex );
+	mDcRemoval = enabled;
+	boost::mutex::scoped_lock userLock( mUserMutex );
+	for ( map<uint32_t, UserRef>::iterator userIt = mUsers.begin(); userIt != mUsers.end(); ++userIt ) {
+		userIt->second->mPreprocessor->setDcRemoval( enabled );
+	}
+}
+
+// Set dispatch mode
+void Emotiv::setDispatchMode( int32_t mode, uint32_t queueSize, int32_t dropPolicy )
+{
+
+	// Let a producer blocked on the old queue move on
+	EventQueueRef eventQueue = getEventQueue();
+	if ( eventQueue ) {
+		eventQueue->close();
+	}
+
+	// Swap queue while the acquisition thread is between events
+	boost::mutex::scoped_lock lock( mMutex );
+	boost::mutex::scoped_lock queueLock( mEventQueueMutex );
+	mDispatchMode = mode;
+	if ( mode == DISPATCH_QUEUED ) {
+		mEventQueue = EmotivQueue<EmotivEvent>::create( queueSize, dropPolicy );
+	} else {
+		mEventQueue.reset();
+	}
+
+}
+
+// Select spectral estimator
+void Emotiv::setFftMode( int32_t mode )
+{
+	boost::mutex::scoped_lock lock( mMutex );
+	mFftMode = mode;
+	boost::mutex::scoped_lock userLock( mUserMutex );
+	for ( map<uint32_t, UserRef>::iterator userIt = mUsers.begin(); userIt != mUsers.end(); ++userIt ) {
+		userIt->second->mSpectrum->setMode( mode );
+	}
+}
+
+// Set FFT window and hop size
+void Emotiv::setFftWindow( uint32_t windowSize, uint32_t hopSize )
+{
+	boost::mutex::scoped_lock lock( mMutex );
+	mFftWindowSize = min( windowSize, RAW_BUFFER_SIZE );
+	mFftHopSize = hopSize;
+	boost::mutex::scoped_lock userLock( mUserMutex );
+	for ( map<uint32_t, UserRef>::iterator userIt = mUsers.begin(); userIt != mUsers.end(); ++userIt ) {
+		userIt->second->mLastHopSample = userIt->second->mRawBuffer->getWriteCount();
+	}
+}
+
+// Select FFT window function
+void Emotiv::setFftWindowFunction( int32_t windowFunction )
+{
+	boost::mutex::scoped_lock lock( mMutex );
+	mFftWindowFunction = windowFunction;
+	boost::mutex::scoped_lock userLock( mUserMutex );
+	for ( map<uint32_t, UserRef>::iterator userIt = mUsers.begin(); userIt != mUsers.end(); ++userIt ) {
+		userIt->second->mSpectrum->setWindowFunction( windowFunction );
+	}
+}
+
+// Set lost sample interpolation
+void Emotiv::setGapFill( bool enabled, uint32_t maxSamples )
+{
+	boost::mutex::scoped_lock lock( mMutex );
+	mGapFill = enabled;
+	mMaxGapFill = maxSamples;
+	reserve();
+}
+
+// Set frequencies for the Goertzel analyzer
+void Emotiv::setGoertzelTargets( const vector<float> &frequencies )
+{
+	boost::mutex::scoped_lock lock( mMutex );
+	mGoertzelTargets = frequencies;
+	boost::mutex::scoped_lock userLock( mUserMutex );
+	for ( map<uint32_t, UserRef>::iterator userIt = mUsers.begin(); userIt != mUsers.end(); ++userIt ) {
+		EmotivGoertzelRef & goertzel = userIt->second->mGoertzel;
+		if ( goertzel ) {
+			goertzel->clearTargets();
+			for ( vector<float>::const_iterator targetIt = frequencies.begin(); targetIt != frequencies.end(); ++targetIt ) {
+				goertzel->addTarget( *targetIt );
 			}
+		}
+	}
+}
+
+// Set mains notch frequency
+void Emotiv::setNotchFrequency( float frequency )
+{
+	boost::mutex::scoped_lock lock( mMutex );
+	mNotchFrequency = frequency;
+	boost::mutex::scoped_lock userLock( mUserMutex );
+	for ( map<uint32_t, UserRef>::iterator userIt = mUsers.begin(); userIt != mUsers.end(); ++userIt ) {
+		userIt->second->mPreprocessor->setNotchFrequency( frequency );
+	}
+}
+
+// Set sample rate of incoming data. Users added after 
+// this are analyzed at the new rate.
+void Emotiv::setSampleRate( uint32_t sampleRate )
+{
+	mSampleRate = sampleRate;
+	reserve();
+}
 
+// Turn profiling on or off
+void Emotiv::setProfiling( bool enabled, uint32_t capacity )
+{
+	TimingQueueRef timingQueue;
+	if ( enabled ) {
+		timingQueue = EmotivQueue<EmotivTiming>::create( capacity, EmotivQueue<EmotivTiming>::DROP_OLDEST );
+	}
+	boost::mutex::scoped_lock lock( mMutex );
+	mTimingQueue = timingQueue;
+}
+
+// Set idle polling interval
+void Emotiv::setPollInterval( double interval, double maxInterval )
+{
+	boost::mutex::scoped_lock lock( mMutex );
+	mPollInterval = max( interval, 0.0 );
+	mMaxPollInterval = max( maxInterval, mPollInterval );
+}
+
+// Set number of DSP worker threads
+void Emotiv::setThreadCount( uint32_t numThreads )
+{
+
+	// Start new workers outside the lock
+	EmotivTaskPoolRef taskPool;
+	if ( numThreads > 0 ) {
+		taskPool = EmotivTaskPool::create( numThreads );
+	}
+
+	// Swap pools while the acquisition thread is between events
+	{
+		boost::mutex::scoped_lock lock( mMutex );
+		taskPool.swap( mTaskPool );
+		boost::mutex::scoped_lock userLock( mUserMutex );
+		for ( map<uint32_t, UserRef>::iterator userIt = mUsers.begin(); userIt != mUsers.end(); ++userIt ) {
+			userIt->second->mSpectrum->setTaskPool( mTaskPool );
+			if ( userIt->second->mFilterBank ) {
+				userIt->second->mFilterBank->setTaskPool( mTaskPool );
+			}
+			if ( userIt->second->mGoertzel ) {
+				userIt->second->mGoertzel->setTaskPool( mTaskPool );
+			}
+			if ( userIt->second->mWavelet ) {
+				userIt->second->mWavelet->setTaskPool( mTaskPool );
+			}
 		}
+	}
 
+	// The old workers are joined here, when the last reference goes
+
+}
+
+// Set Welch segment size and count
+void Emotiv::setWelch( uint32_t segmentSize, uint32_t segmentCount )
+{
+	boost::mutex::scoped_lock lock( mMutex );
+	mWelchSegmentCount = max( segmentCount, 1u );
+	mWelchSegmentSize = min( segmentSize, RAW_BUFFER_SIZE );
+	boost::mutex::scoped_lock userLock( mUserMutex );
+	for ( map<uint32_t, UserRef>::iterator userIt = mUsers.begin(); userIt != mUsers.end(); ++userIt ) {
+		userIt->second->mSpectrum->setWelch( mWelchSegmentSize, mWelchSegmentCount );
+	}
+}
+
+// Start recording session
+bool Emotiv::startRecording( const fs::path &path )
+{
+
+	// Finish any previous recording
+	stopRecording();
+
+	// Open file
+	EmotivRecorderRef recorder = EmotivRecorder::create( path, sizeof( EmotivEvent ), EEG_CHANNEL_COUNT, mSampleRate, mTimer.getSeconds() );
+	if ( !recorder ) {
+		return false;
+	}
+
+	// Hand it to the acquisition thread
+	boost::mutex::scoped_lock lock( mMutex );
+	mRecorder = recorder;
+	return true;
+
+}
+
+// Maps a new block onto Emotiv's clock, returning the time of its 
+// first sample. Blocks can only arrive late, so the smallest offset 
+// between the clocks has the least transport delay in it. Larger 
+// offsets are followed slowly so drift between the clocks is not 
+// mistaken for latency.
+double Emotiv::stampBlock( User &user, uint32_t count, double now )
+{
+
+	// Use the headset's timestamps, or count samples from 
+	// the start if there are none
+	double first = mTimestampData[ 0 ];
+	double newest = mTimestampData[ count - 1 ];
+	if ( !( newest > 0.0 ) || newest < first ) {
+		newest = (double)user.mRawBuffer->getWriteCount() / (double)mSampleRate;
+		first = newest - (double)( count - 1 ) / (double)mSampleRate;
 	}
 
-	// Unlock scope
-	mMutex.unlock();
+	// Start over if the headset clock went back
+	if ( newest < user.mClockTimestamp ) {
+		user.mClockValid = false;
+	}
+	user.mClockTimestamp = newest;
+
+	// Track the offset and measure latency against it
+	double offset = now - newest;
+	if ( !user.mClockValid || offset < user.mClockOffset ) {
+		user.mClockOffset = offset;
+		user.mClockValid = true;
+	} else {
+		user.mClockOffset += ( offset - user.mClockOffset ) * CLOCK_DRIFT_RATE;
+	}
+	mStatAcquisitionLatency.store( toNanoseconds( now - newest - user.mClockOffset ), boost::memory_order_relaxed );
+	return first + user.mClockOffset;
+
+}
+
+// Clear timing for an event read at "time"
+void Emotiv::startTiming( double time )
+{
+	mEventTime = time;
+	mTiming.mDecode = 0.0;
+	mTiming.mDispatch = 0.0;
+	mTiming.mFetch = 0.0;
+	mTiming.mFft = 0.0;
+	mTiming.mLatency = 0.0;
+	mTiming.mReduce = 0.0;
+}
+
+// Stop playing session
+void Emotiv::stopPlayback()
+{
+	boost::mutex::scoped_lock lock( mMutex );
+	mPlayer.reset();
+}
+
+// Stop recording session
+void Emotiv::stopRecording()
+{
+
+	// Take recorder away from the acquisition thread
+	EmotivRecorderRef recorder;
+	{
+		boost::mutex::scoped_lock lock( mMutex );
+		recorder.swap( mRecorder );
+	}
+
+	// Flush and close file outside the lock
+	if ( recorder ) {
+		recorder->stop();
+	}
+
+}
+
+// Roll the event rate window over once a second
+void Emotiv::updateStats()
+{
+	double now = mTimer.getSeconds();
+	double elapsed = now - mStatWindowStart;
+	if ( elapsed < 1.0 ) {
+		return;
+	}
+	for ( int32_t i = 0; i < EmotivEngine::EVENT_TYPE_COUNT; i++ ) {
+		uint64_t count = mStatEventCounts[ i ].load( boost::memory_order_relaxed );
+		mStatEventRates[ i ].store( static_cast<uint64_t>( (double)( count - mStatWindowCounts[ i ] ) * 1000.0 / elapsed ), boost::memory_order_relaxed );
+		mStatWindowCounts[ i ] = count;
+	}
+	mStatWindowStart = now;
+}
+
+// Main loop
+void Emotiv::update()
+{
+
+	// Start at the shortest interval
+	double interval = mPollInterval;
+
+	while ( true ) {
+
+		// Lock scope for this iteration only so other threads can 
+		// get in between events
+		boost::mutex::scoped_lock lock( mMutex );
+
+		// Check running flag
+		if ( !mRunning ) {
+			EmotivScopedUnlock unlock( mMutex );
+			flush( mBatch );
+			break;
+		}
+		mStatLoopIterations.fetch_add( 1, boost::memory_order_relaxed );
+		updateStats();
+
+		// Fetch raw data when it is due. Late ticks are not made 
+		// up, since each fetch takes everything buffered.
+		double wait = interval;
+		if ( mConnected && mAcquisitionInterval > 0.0 ) {
+			double now = mTimer.getSeconds();
+			if ( now >= mNextAcquisitionTime ) {
+				acquireUsers();
+				mNextAcquisitionTime = max( mNextAcquisitionTime + mAcquisitionInterval, now );
+			}
+			wait = min( wait, max( mNextAcquisitionTime - mTimer.getSeconds(), 0.0 ) );
+		}
+
+		// Drain events and recorded records back to back while 
+		// they are available
+		uint64_t allocationCount = getThreadAllocationCount();
+		if ( ( mConnected && processEvent() ) || ( mPlayer && processRecord( wait ) ) ) {
+			mEventAllocationCount += getThreadAllocationCount() - allocationCount;
+			mEventCount++;
+			interval = mPollInterval;
+			continue;
+		}
+
+		// Nothing to do. End the tick's batch and sleep until the 
+		// interval passes, the next recorded record or raw fetch is 
+		// due or disconnect() wakes us up, then back off.
+		if ( !mBatch.empty() ) {
+			double start = mTimer.getSeconds();
+			{
+				EmotivScopedUnlock unlock( mMutex );
+				flush( mBatch );
+			}
+			mStatCallbackTime.store( toNanoseconds( mTimer.getSeconds() - start ), boost::memory_order_relaxed );
+			if ( !mRunning ) {
+				continue;
+			}
+		}
+		mCondition.timed_wait( lock, boost::posix_time::microseconds( static_cast<int64_t>( wait * 1000000.0 ) ) );
+		interval = min( interval * 2.0, mMaxPollInterval );
+
+	}
 
 }
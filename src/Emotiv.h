@@ -41,162 +41,27 @@
 #include "boost/bind.hpp"
 #include "boost/filesystem.hpp"
 #include "boost/signals2.hpp"
+#include "boost/thread/condition_variable.hpp"
 #include "boost/thread/thread.hpp"
 #include "boost/thread/mutex.hpp"
 #include "cinder/app/App.h"
 #include "cinder/Cinder.h"
+#include "cinder/Timer.h"
 #include "cinder/Utilities.h"
-#include "emotiv/EmoStateDLL.h"
-#include "emotiv/edk.h"
-#include "emotiv/edkErrorCode.h"
-#include "KissFFT.h"
-#ifdef CINDER_MSW
-	#include "ppl.h"
-#endif
-
-// Emotiv event
-class EmotivEvent
-{
-
-private:
-
-	// Event properties
-	float					mTime;
-	uint32_t				mUserId;
-	EE_SignalStrength_t		mWirelessSignalStatus;
-	int32_t					mBlink;
-	int32_t					mWinkLeft;
-	int32_t					mWinkRight;
-	int32_t					mLookLeft;
-	int32_t					mLookRight;
-	float					mEyebrow;
-	float					mFurrow;
-	float					mSmile;
-	float					mClench;
-	float					mSmirkLeft;
-	float					mSmirkRight;
-	float					mLaugh;
-	float					mShortTermExcitement;
-	float					mLongTermExcitement;
-	float					mEngagementBoredom;
-	EE_CognitivAction_t		mCognitivAction;
-	float					mCognitivPower;
-	float					mAlpha;
-	float					mBeta;
-	float					mDelta;
-	float					mGamma;
-	float					mTheta;
-
-public:
-
-	// Wireless signal constants
-	static const int32_t BAD_SIGNAL =					static_cast<int32_t>( EE_SignalStrength_t::BAD_SIGNAL );
-	static const int32_t GOOD_SIGNAL =					static_cast<int32_t>( EE_SignalStrength_t::GOOD_SIGNAL );
-	static const int32_t NO_SIGNAL =					static_cast<int32_t>( EE_SignalStrength_t::NO_SIGNAL );
-
-	// Cognitive action constants
-	static const int32_t COG_DISAPPEAR =				static_cast<int32_t>( EE_CognitivAction_t::COG_DISAPPEAR );
-	static const int32_t COG_DROP =						static_cast<int32_t>( EE_CognitivAction_t::COG_DROP );
-	static const int32_t COG_LEFT =						static_cast<int32_t>( EE_CognitivAction_t::COG_LEFT );
-	static const int32_t COG_LIFT =						static_cast<int32_t>( EE_CognitivAction_t::COG_LIFT );
-	static const int32_t COG_NEUTRAL =					static_cast<int32_t>( EE_CognitivAction_t::COG_NEUTRAL );
-	static const int32_t COG_PULL =						static_cast<int32_t>( EE_CognitivAction_t::COG_PULL );
-	static const int32_t COG_PUSH =						static_cast<int32_t>( EE_CognitivAction_t::COG_PUSH );
-	static const int32_t COG_RIGHT =					static_cast<int32_t>( EE_CognitivAction_t::COG_RIGHT );
-	static const int32_t COG_ROTATE_CLOCKWISE =			static_cast<int32_t>( EE_CognitivAction_t::COG_ROTATE_CLOCKWISE );
-	static const int32_t COG_ROTATE_COUNTER_CLOCKWISE =	static_cast<int32_t>( EE_CognitivAction_t::COG_ROTATE_COUNTER_CLOCKWISE );
-	static const int32_t COG_ROTATE_FORWARDS =			static_cast<int32_t>( EE_CognitivAction_t::COG_ROTATE_FORWARDS );
-	static const int32_t COG_ROTATE_LEFT =				static_cast<int32_t>( EE_CognitivAction_t::COG_ROTATE_LEFT );
-	static const int32_t COG_ROTATE_REVERSE =			static_cast<int32_t>( EE_CognitivAction_t::COG_ROTATE_REVERSE );
-	static const int32_t COG_ROTATE_RIGHT =				static_cast<int32_t>( EE_CognitivAction_t::COG_ROTATE_RIGHT );
-
-	// Con/de-structor
-	EmotivEvent(
-		float time = 0.0f, 
-		uint32_t userId = 0x00, 
-		EE_SignalStrength_t wirelessSignalStatus = EE_SignalStrength_t::NO_SIGNAL, 
-		int32_t blink = 0, 
-		int32_t winkLeft = 0, 
-		int32_t winkRight = 0, 
-		int32_t lookLeft = 0, 
-		int32_t lookRight = 0, 
-		float eyebrow = 0.0f, 
-		float furrow = 0.0f, 
-		float smile = 0.0f, 
-		float clench = 0.0f, 
-		float smirkLeft = 0.0f, 
-		float smirkRight = 0.0f, 
-		float laugh = 0.0f, 
-		float shortTermExcitement = 0.0f, 
-		float longTermExcitement = 0.0f, 
-		float engagementBoredom = 0.0f, 
-		EE_CognitivAction_t cognitivAction = EE_CognitivAction_enum::COG_NEUTRAL, 
-		float cognitivPower = 0.0f, 
-		float alpha = 0.0f, 
-		float beta = 0.0f, 
-		float delta = 0.0f, 
-		float gamma = 0.0f, 
-		float theta = 0.0f
-		) 
-	{
-		mAlpha = alpha;
-		mBeta = beta;
-		mBlink = blink;
-		mClench = clench;
-		mCognitivAction = cognitivAction;
-		mCognitivPower = cognitivPower;
-		mDelta = delta;
-		mEngagementBoredom = engagementBoredom;
-		mEyebrow = eyebrow;
-		mFurrow = furrow;
-		mGamma = gamma;
-		mLaugh = laugh;
-		mLongTermExcitement = longTermExcitement;
-		mLookLeft = lookLeft;
-		mLookRight = lookRight;
-		mShortTermExcitement = shortTermExcitement;
-		mSmile = smile;
-		mSmirkLeft = smirkLeft;
-		mSmirkLeft = smirkRight;
-		mTheta = theta;
-		mTime = time;
-		mUserId = userId;
-		mWinkLeft = winkLeft;
-		mWinkRight = winkRight;
-		mWirelessSignalStatus = wirelessSignalStatus;
-	}
-	~EmotivEvent() 
-	{
-	}
-
-	// Getters
-	float		getTime() { return mTime; }
-	uint32_t	getUserId() { return mUserId; }
-	int32_t		getWirelessSignalStatus() { return static_cast<int32_t>( mWirelessSignalStatus ); }
-	int32_t		getBlink() { return mBlink; }
-	int32_t		getWinkLeft() { return mWinkLeft; }
-	int32_t		getWinkRight() { return mWinkRight; }
-	int32_t		getLookLeft() { return mLookLeft; }
-	int32_t		getLookRight() { return mLookRight; }
-	float		getEyebrow() { return mEyebrow; }
-	float		getFurrow() { return mFurrow; }
-	float		getSmile() { return mSmile; }
-	float		getClench() { return mClench; }
-	float		getSmirkLeft() { return mSmirkLeft; }
-	float		getSmirkRight() { return mSmirkRight; }
-	float		getLaugh() { return mLaugh; }
-	float		getShortTermExcitement() { return mShortTermExcitement; }
-	float		getLongTermExcitement() { return mLongTermExcitement; }
-	float		getEngagementBoredom() { return mEngagementBoredom; }
-	int32_t		getCognitivAction() { return static_cast<int32_t>( mCognitivAction ); }
-	float		getCognitivPower() { return mCognitivPower; }
-	float		getAlpha() { return mAlpha; }
-	float		getBeta() { return mBeta; }
-	float		getDelta() { return mDelta; }
-	float		getGamma() { return mGamma; }
-	float		getTheta() { return mTheta; }
-
-};
+#include "EmotivEngine.h"
+#include "EmotivFilterBank.h"
+#include "EmotivGoertzel.h"
+#include "EmotivPlayer.h"
+#include "EmotivPreprocessor.h"
+#include "EmotivQueue.h"
+#include "EmotivRawView.h"
+#include "EmotivRecorder.h"
+#include "EmotivRingBuffer.h"
+#include "EmotivSpectrum.h"
+#include "EmotivStats.h"
+#include "EmotivTaskPool.h"
+#include "EmotivTiming.h"
+#include "EmotivWavelet.h"
 
 // Emotiv pointer alias
 typedef std::shared_ptr<class Emotiv> EmotivRef;
@@ -211,8 +76,30 @@ public:
 	static const uint16_t COMPOSER_PORT =	1726;
 	static const uint16_t REMOTE_PORT =		3008;
 
-	// Create pointer to Emotiv instance
-	static EmotivRef	create();
+	// Number of EEG channels to use in FFT calculation
+	static const int32_t EEG_CHANNEL_COUNT =	14;
+
+	// Samples of raw EEG kept per channel, per user (16s at 128Hz)
+	static const uint32_t RAW_BUFFER_SIZE =		2048;
+
+	// Dispatch modes
+	static const int32_t DISPATCH_IMMEDIATE =	0;
+	static const int32_t DISPATCH_QUEUED =		1;
+
+	// Raw callback layouts
+	static const int32_t RAW_LAYOUT_PLANAR =		0;
+	static const int32_t RAW_LAYOUT_INTERLEAVED =	1;
+
+	// Band power analyzers
+	static const int32_t ANALYZER_SPECTRUM =	0;
+	static const int32_t ANALYZER_GOERTZEL =	1;
+	static const int32_t ANALYZER_FILTER_BANK =	2;
+	static const int32_t ANALYZER_WAVELET =		3;
+
+	// Create pointer to Emotiv instance. Events and raw EEG come 
+	// from "engine", which defaults to the Emotiv EDK, or to an 
+	// EmotivSimulator when building with EMOTIV_NO_EDK.
+	static EmotivRef	create( const EmotivEngineRef &engine = EmotivEngineRef() );
 
 	// Con/de-structor
 	~Emotiv();
@@ -223,30 +110,243 @@ public:
 	bool				disconnect();
 	int32_t				getNumUsers();
 
+	// Engine backend
+	EmotivEngineRef		getEngine() { return mEngine; }
+
 	// Dis/en-able FFT
 	void				enableFft( bool enabled ) { mFftEnabled = enabled; }
 	bool				fftEnabled() { return mFftEnabled; }
 
+	// Band power analyzer. ANALYZER_SPECTRUM (default) runs the FFT 
+	// or Welch estimator on the FFT window cadence. ANALYZER_GOERTZEL 
+	// tracks only the frequencies given to setGoertzelTargets() over 
+	// the last FFT window of samples, updating with every block and 
+	// dispatching each result. ANALYZER_FILTER_BANK follows each 
+	// band's envelope sample by sample (see getEnvelopeBuffer()) and 
+	// also dispatches with every block. ANALYZER_WAVELET takes each 
+	// band's energy from a streaming Daubechies-4 decomposition over 
+	// the last FFT window, updating with every block. All of them 
+	// report through getBandPower() and the brainwave fields of events.
+	int32_t				getAnalyzer() { return mAnalyzerType; }
+	void				setAnalyzer( int32_t analyzer );
+	void				setGoertzelTargets( const std::vector<float> &frequencies );
+
+	// FFT window. By default the last second of samples is 
+	// analyzed once per second. A non-zero "hopSize" switches to 
+	// short-time mode: the last "windowSize" samples are analyzed 
+	// every "hopSize" new samples and an event is dispatched with 
+	// each result. Pass zero as "windowSize" to use one second.
+	uint32_t			getFftHopSize() { return mFftHopSize; }
+	uint32_t			getFftWindowSize();
+	void				setFftWindow( uint32_t windowSize, uint32_t hopSize = 0 );
+
+	// Window function applied to each FFT frame, one of 
+	// EmotivSpectrum::WINDOW_RECTANGULAR, WINDOW_HANN (default), 
+	// WINDOW_HAMMING or WINDOW_BLACKMAN
+	int32_t				getFftWindowFunction() { return mFftWindowFunction; }
+	void				setFftWindowFunction( int32_t windowFunction );
+
+	// Spectral estimator, EmotivSpectrum::MODE_FFT (default) or 
+	// MODE_WELCH. Welch mode averages the power of the last 
+	// "segmentCount" segments of "segmentSize" samples, overlapping 
+	// by half, for steadier band power. Events still follow the FFT 
+	// window cadence set above, but the window size is not used.
+	int32_t				getFftMode() { return mFftMode; }
+	void				setFftMode( int32_t mode );
+	void				setWelch( uint32_t segmentSize, uint32_t segmentCount );
+
+	// Preprocessing. Acquired samples have their DC offset removed 
+	// (on by default) and mains hum notched out at "frequency" Hz 
+	// (off by default, pass 50 or 60 to match local mains) before 
+	// they reach the raw buffer. See EmotivPreprocessor.
+	bool				getDcRemoval() { return mDcRemoval; }
+	float				getNotchFrequency() { return mNotchFrequency; }
+	void				setDcRemoval( bool enabled );
+	void				setNotchFrequency( float frequency );
+
+	// DSP threads. Each analysis pass spreads its channels across 
+	// "numThreads" workers and the acquisition thread, joining them 
+	// before the event is dispatched. The pool is shared by all users. 
+	// Zero (default) keeps all analysis on the acquisition thread.
+	uint32_t			getThreadCount();
+	void				setThreadCount( uint32_t numThreads );
+
+	// Event polling. The engine is polled every "interval" seconds 
+	// while idle. The wait doubles after each empty poll until it 
+	// reaches "maxInterval", then resets when an event arrives.
+	double				getMaxPollInterval() { return mMaxPollInterval; }
+	double				getPollInterval() { return mPollInterval; }
+	void				setPollInterval( double interval, double maxInterval );
+
+	// Lost samples. Gaps are found from the headset's packet counter, 
+	// and from its timestamps once the counter has wrapped around. 
+	// When enabled, gaps of up to "maxSamples" are filled by linear 
+	// interpolation so the raw buffer stays evenly spaced in time 
+	// and analysis windows keep their length. Longer gaps are only 
+	// counted. Off by default.
+	bool				getGapFill() { return mGapFill; }
+	void				setGapFill( bool enabled, uint32_t maxSamples = 32 );
+
+	// Seconds on Emotiv's monotonic clock, which raw block times, 
+	// recorded record times and profiling use. EmotivEvent::getTime() 
+	// is the engine's own EmoState time and is not on this clock.
+	double				getTime() { return mTimer.getSeconds(); }
+
+	// Raw data cadence. By default raw samples are fetched whenever 
+	// an EmoState arrives, and the engine buffers one FFT window of 
+	// them in between. A non-zero "interval" fetches every user's 
+	// samples on its own clock instead, whether or not EmoStates 
+	// arrive, and shrinks the engine's buffer to "bufferTime" 
+	// seconds (four intervals if zero). 0.0625 fetches every eight 
+	// samples at 128Hz, for low latency without gaps. Analysis then 
+	// runs on this clock too. Streaming analyzers and short-time 
+	// hops dispatch the user's latest EmoState with each result, 
+	// and EmoStates are dispatched as they arrive, carrying the 
+	// latest band power.
+	double				getAcquisitionInterval() { return mAcquisitionInterval; }
+	double				getDataBufferTime() { return mDataBufferTime; }
+	void				setAcquisitionInterval( double interval, double bufferTime = 0.0 );
+
+	// Band power of each EEG channel from the latest FFT pass 
+	// for a user, along with the average across channels
+	EmotivBandPower		getBandPower( uint32_t userId = 0x00 );
+
+	// Raw EEG. Returns the ring buffer holding the latest samples
+	// of each EEG channel for a user, or an empty pointer if the user 
+	// has not been added. Channels are stored in the order AF3, F7, F3, 
+	// FC5, T7, P7, O1, O2, P8, T8, FC6, F4, F8, AF4, after preprocessing. 
+	// The buffer can be read from any thread without locking.
+	EmotivRingBufferRef	getRawBuffer( uint32_t userId = 0x00 );
+
+	// Per-sample band envelopes from ANALYZER_FILTER_BANK. Returns 
+	// an empty pointer if the user has not been added or the filter 
+	// bank has not been selected yet. See 
+	// EmotivFilterBank::getEnvelopeBuffer() for the channel layout.
+	EmotivRingBufferRef	getEnvelopeBuffer( uint32_t userId = 0x00 );
+
+	// Heap allocations made by the acquisition thread per handled 
+	// event, averaged since creation or the last reset. Call 
+	// resetAllocationCount() after warming up; the steady state 
+	// should report zero. Requires building with 
+	// EMOTIV_COUNT_ALLOCATIONS, otherwise this always returns zero.
+	double				getAllocationsPerEvent();
+	void				resetAllocationCount();
+
+	// Runtime counters, read without locking
+	EmotivStats			getStats();
+
+	// Profiling. While enabled, the time spent in each stage of 
+	// handling an event is kept for every dispatched event, up to 
+	// "capacity" of them, dropping the oldest. getTimings() appends 
+	// the kept timings to "timings", returning how many were added.
+	bool				profiling();
+	void				setProfiling( bool enabled, uint32_t capacity = 4096 );
+	uint32_t			getTimings( std::vector<EmotivTiming> &timings );
+
+	// Session recording. Every dispatched event and every raw EEG 
+	// block is written to a binary file at "path" (see EmotivRecorder 
+	// for the layout). Disk writes happen on a background thread; if 
+	// they fall behind, records are dropped and counted rather than 
+	// stalling acquisition.
+	uint64_t			getRecordingDropCount();
+	bool				recording();
+	bool				startRecording( const ci::fs::path &path );
+	void				stopRecording();
+
+	// Session playback. Replays a file written by startRecording() 
+	// through the normal callback path, re-running the analysis on 
+	// the recorded raw EEG. "speed" scales the recorded timing: 1 is 
+	// real time, 4 is four times faster and 0 plays as fast as 
+	// possible. Works without connecting, so sessions can be replayed 
+	// on machines with no headset. Returns false if the file cannot 
+	// be read.
+	bool				play( const ci::fs::path &path, float speed = 1.0f );
+	bool				playing();
+	void				stopPlayback();
+
 	// Profiles
 	static std::map<ci::fs::path, std::string>	listProfiles( const ci::fs::path &dataPath = "" );
 	bool										loadProfile( const ci::fs::path &profilePath, uint32_t userId = 0x00 );
 
-	// Callbacks
-	int32_t				addCallback( const boost::function<void ( EmotivEvent event )> & callback );
+	// Callbacks. Events are passed by const reference, so no slot 
+	// copies them. Member functions taking the event by value are 
+	// still accepted, but pay for the copy. Callbacks run without 
+	// Emotiv's lock held, so they may call any method except 
+	// disconnect(), which waits for the thread they run on. 
+	// Settings changed from a callback apply from the next event.
+	int32_t				addCallback( const boost::function<void ( const EmotivEvent &event )> & callback );
+	template<typename T>
+	int32_t				addCallback( void ( T::* callbackFunction )( const EmotivEvent &event ), T * callbackObject )
+	{
+		return addCallback( boost::function<void ( const EmotivEvent &event )>( boost::bind( callbackFunction, callbackObject, ::_1 ) ) );
+	}
 	template<typename T>
 	int32_t				addCallback( void ( T::* callbackFunction )( EmotivEvent event ), T * callbackObject )
 	{
-		return addCallback( boost::function<void ( EmotivEvent event )>( boost::bind( callbackFunction, callbackObject, ::_1 ) ) );
+		return addCallback( boost::function<void ( const EmotivEvent &event )>( boost::bind( callbackFunction, callbackObject, ::_1 ) ) );
 	}
 	void				removeCallback( int32_t callbackID );
 
-private:
+	// Batch callbacks receive events as one contiguous array, 
+	// oldest first, instead of one call per event. A batch goes 
+	// out once "batchSize" events have collected, or when the 
+	// acquisition thread runs out of events for this tick, so 
+	// nothing waits longer than one poll interval. They run 
+	// wherever single callbacks do: on the acquisition thread, 
+	// or in poll() in DISPATCH_QUEUED mode. A new batch size applies 
+	// from the next event on. Remove them with removeCallback().
+	int32_t				addBatchCallback( const boost::function<void ( const EmotivEvent *events, uint32_t count )> &callback );
+	template<typename T>
+	int32_t				addBatchCallback( void ( T::* callbackFunction )( const EmotivEvent *events, uint32_t count ), T * callbackObject )
+	{
+		return addBatchCallback( boost::function<void ( const EmotivEvent *events, uint32_t count )>( boost::bind( callbackFunction, callbackObject, ::_1, ::_2 ) ) );
+	}
+	uint32_t			getBatchSize() { return mBatchSize; }
+	void				setBatchSize( uint32_t batchSize );
+
+	// Raw callbacks see each block of EEG as soon as it is acquired 
+	// or played back, after preprocessing, through a read-only view 
+	// instead of a copy. RAW_LAYOUT_PLANAR (default) views point into 
+	// the raw buffer itself, one channel after another, and a block 
+	// that wraps around the end of the buffer arrives as two views. 
+	// RAW_LAYOUT_INTERLEAVED views hold one frame of all channels 
+	// after another, transposed once per block for all subscribers. 
+	// Raw callbacks always run on the acquisition thread, in either 
+	// dispatch mode, and must not keep the view. Like event callbacks 
+	// they run without Emotiv's lock held and may call any method 
+	// except disconnect(). Remove them with removeCallback().
+	int32_t				addRawCallback( const boost::function<void ( const EmotivRawView &view )> &callback, int32_t layout = RAW_LAYOUT_PLANAR );
+	template<typename T>
+	int32_t				addRawCallback( void ( T::* callbackFunction )( const EmotivRawView &view ), T * callbackObject, int32_t layout = RAW_LAYOUT_PLANAR )
+	{
+		return addRawCallback( boost::function<void ( const EmotivRawView &view )>( boost::bind( callbackFunction, callbackObject, ::_1 ) ), layout );
+	}
 
-	// Number of EEG channels to use in FFT calculation
-	static const int32_t EEG_CHANNEL_COUNT =	14;
+	// Dispatch. In DISPATCH_IMMEDIATE mode (default) callbacks run on 
+	// the acquisition thread as events arrive. In DISPATCH_QUEUED mode 
+	// events are stored in a queue of "queueSize" and callbacks run on 
+	// whichever thread calls poll(). "dropPolicy" is one of 
+	// EmotivQueue<EmotivEvent>::DROP_OLDEST, DROP_NEWEST or BLOCK. With 
+	// BLOCK, acquisition stalls until poll() makes room, so set the mode 
+	// before connecting. The stalled thread holds no lock while it 
+	// waits, so any method may be called from the polling thread, but 
+	// settings changed then apply from the next event on.
+	int32_t				getDispatchMode() { return mDispatchMode; }
+	void				setDispatchMode( int32_t mode, uint32_t queueSize = 256, int32_t dropPolicy = EmotivQueue<EmotivEvent>::DROP_OLDEST );
+
+	// Runs callbacks for up to "maxEvents" queued events (all if zero) 
+	// on the calling thread. Returns the number dispatched.
+	uint32_t			poll( uint32_t maxEvents = 0 );
+
+	// Queue statistics. Overflows count events pushed while the 
+	// queue was full, whether they were dropped or waited.
+	uint32_t			getQueueDepth();
+	uint64_t			getQueueOverflowCount();
+
+private:
 
 	// Constructor
-	Emotiv();
+	Emotiv( const EmotivEngineRef &engine );
 
 	// Callback aliases
 	typedef		boost::signals2::connection Callback;
@@ -254,36 +354,166 @@ private:
 	typedef		std::map<int32_t, CallbackRef> CallbackList;
 
 	// Callbacks
-	boost::signals2::signal<void ( EmotivEvent )>	mSignal;
-	CallbackList									mCallbacks;
-
-	// Event handlers
-	EmoEngineEventHandle	mEvent;
-	EmoStateHandle			mState;
-
-	// Connected status
+	boost::signals2::signal<void ( const EmotivEvent & )>	mSignal;
+	CallbackList											mCallbacks;
+	int32_t													nextCallbackId();
+
+	// Batches. "mBatch" collects events on the acquisition thread 
+	// and keeps "mBatchSize" capacity, so collecting never allocates. 
+	// poll() sends batches straight from the events it takes, kept 
+	// in "mPollEvents" between calls.
+	typedef boost::signals2::signal<void ( const EmotivEvent *, uint32_t )>	BatchSignal;
+	void							collect( std::vector<EmotivEvent> &batch, const EmotivEvent &event );
+	void							flush( std::vector<EmotivEvent> &batch );
+	std::vector<EmotivEvent>		mBatch;
+	BatchSignal						mBatchSignal;
+	boost::atomic<uint32_t>			mBatchSize;
+	std::vector<EmotivEvent>		mPollEvents;
+	boost::mutex					mPollMutex;
+
+	// Raw callbacks, by layout
+	typedef boost::signals2::signal<void ( const EmotivRawView & )>	RawSignal;
+	std::vector<float>				mInterleavedData;
+	RawSignal						mRawSignals[ 2 ];
+
+	// Event queue
+	typedef std::shared_ptr<EmotivQueue<EmotivEvent> >	EventQueueRef;
+	void							dispatch( const EmotivEvent &event );
+	int32_t							mDispatchMode;
+	EventQueueRef					mEventQueue;
+	boost::mutex					mEventQueueMutex;
+	EventQueueRef					getEventQueue();
+
+	// Engine
 	bool					mConnected;
+	EmotivEngineRef			mEngine;
+
+	// Acquisition state of one headset, created when the user 
+	// is added and released when they are removed
+	struct User
+	{
+		User( uint32_t userId, uint32_t sampleRate, const EmotivTaskPoolRef &taskPool );
+
+		EmotivAnalyzerRef		mAnalyzer;
+		EmotivBandPower			mBandPower;
+		EmotivFilterBankRef		mFilterBank;
+		EmotivGoertzelRef		mGoertzel;
+		double					mClockOffset;
+		double					mClockTimestamp;
+		bool					mClockValid;
+		int32_t					mLastCounter;
+		uint64_t				mLastHopSample;
+		double					mLastRaw[ EEG_CHANNEL_COUNT ];
+		double					mLastTimestamp;
+		uint64_t				mLastSampleCount;
+		EmotivEvent				mLastState;
+		EmotivPreprocessorRef	mPreprocessor;
+		EmotivRingBufferRef		mRawBuffer;
+		EmotivSpectrumRef		mSpectrum;
+		bool					mStateValid;
+		uint32_t				mUserId;
+		EmotivWaveletRef		mWavelet;
+	};
+	typedef std::shared_ptr<User>	UserRef;
+
+	// Users by ID
+	UserRef							addUser( uint32_t userId );
+	UserRef							getUser( uint32_t userId );
+	void							removeUser( uint32_t userId );
+	std::map<uint32_t, UserRef>		mUsers;
+	boost::mutex					mUserMutex;
 
 	// Raw EEG data, FFT
-	DataHandle				mData;
-	KissRef					mFft;
+	void					acquire( User &user );
+	void					acquireUsers();
+	double					mAcquisitionInterval;
+	std::vector<UserRef>	mAcquisitionUsers;
+	double					mDataBufferTime;
+	double					mNextAcquisitionTime;
+	void					publishRaw( const User &user, uint32_t count, double time );
+	uint32_t				findGaps( User &user, uint32_t count, uint32_t &duplicates );
+	double					stampBlock( User &user, uint32_t count, double now );
+	std::vector<double>		mFillData;
+	bool					mGapFill;
+	std::vector<int32_t>	mGapData;
+	uint32_t				mMaxGapFill;
+	std::vector<double>		mTimestampData;
+	void					selectAnalyzer( User &user );
+	int32_t					mAnalyzerType;
+	std::vector<float>		mGoertzelTargets;
+	void					reserve();
+	bool					analyze( User &user, uint64_t end );
+	bool					analyzeNew( User &user, EmotivEvent &event, bool dispatchStreaming );
+	void					setBrainwaves( const User &user, EmotivEvent &event );
+	void					setSampleRate( uint32_t sampleRate );
+	EmotivTaskPoolRef		mTaskPool;
 	bool					mFftEnabled;
-	float *					mFreqData;
-	EE_DataChannel_t		mTargetChannelList[ 22 ];
+	uint32_t				mFftHopSize;
+	uint32_t				mFftWindowSize;
+	std::vector<double>		mCounterData;
+	bool					mDcRemoval;
+	int32_t					mFftMode;
+	int32_t					mFftWindowFunction;
+	float					mNotchFrequency;
+	std::vector<double>		mRawData;
+	uint32_t				mSampleRate;
 	double					mSampleTime;
-	double					mLastSampleTime;
-
-	// Brainwave frequencies
-	float					mAlpha;
-	float					mBeta;
-	float					mDelta;
-	float					mGamma;
-	float					mTheta;
+	uint32_t				mWelchSegmentCount;
+	uint32_t				mWelchSegmentSize;
+
+	// Session recorder
+	EmotivRecorderRef		mRecorder;
+
+	// Session player
+	EmotivPlayerRef			mPlayer;
+	float					mPlaybackEventTime;
+	float					mPlaybackSpeed;
+	double					mPlaybackStartTime;
+	uint32_t				mPlaybackUserId;
+
+	// Allocation accounting
+	uint64_t				mEventAllocationCount;
+	uint64_t				mEventCount;
+
+	// Statistics. Written by the acquisition thread, read by 
+	// getStats(). Times are in nanoseconds, rates in events per 
+	// thousand seconds.
+	boost::atomic<uint64_t>	mStatAcquisitionLatency;
+	boost::atomic<uint64_t>	mStatCallbackTime;
+	boost::atomic<uint64_t>	mStatCounterWraps;
+	boost::atomic<uint64_t>	mStatEventCounts[ EmotivEngine::EVENT_TYPE_COUNT ];
+	boost::atomic<uint64_t>	mStatEventRates[ EmotivEngine::EVENT_TYPE_COUNT ];
+	boost::atomic<uint64_t>	mStatFftTime;
+	boost::atomic<uint64_t>	mStatGapCount;
+	boost::atomic<uint64_t>	mStatLoopIterations;
+	boost::atomic<uint32_t>	mStatQueueDepth;
+	boost::atomic<uint64_t>	mStatSamplesAcquired;
+	boost::atomic<uint64_t>	mStatSamplesDuplicated;
+	boost::atomic<uint64_t>	mStatSamplesInterpolated;
+	boost::atomic<uint64_t>	mStatSamplesLost;
+	uint64_t				mStatWindowCounts[ EmotivEngine::EVENT_TYPE_COUNT ];
+	double					mStatWindowStart;
+	void					updateStats();
+
+	// Profiling. "mEventTime" is when the current event was read.
+	typedef std::shared_ptr<EmotivQueue<EmotivTiming> >	TimingQueueRef;
+	double					mEventTime;
+	EmotivTiming			mTiming;
+	TimingQueueRef			mTimingQueue;
+	ci::Timer				mTimer;
+	void					startTiming( double time );
 
 	// Threading
+	boost::condition_variable		mCondition;
+	double							mMaxPollInterval;
 	boost::mutex					mMutex;
+	double							mPollInterval;
 	bool							mRunning;
 	std::shared_ptr<boost::thread>	mThread;
+	bool							processEvent();
+	void							processBlock( User &user );
+	bool							processRecord( double &wait );
+	void							processState( User &user, EmotivEvent &event );
 	void							update();
 
 };
@@ -0,0 +1,68 @@
+/*
+* 
+* Copyright (c) 2012, Ban the Rewind
+* All rights reserved.
+* 
+* Redistribution and use in source and binary forms, with or 
+* without modification, are permitted provided that the following 
+* conditions are met:
+* 
+* Redistributions of source code must retain the above copyright 
+* notice, this list of conditions and the following disclaimer.
+* Redistributions in binary form must reproduce the above copyright 
+* notice, this list of conditions and the following disclaimer in 
+* the documentation and/or other materials provided with the 
+* distribution.
+* 
+* Neither the name of the Ban the Rewind nor the names of its 
+* contributors may be used to endorse or promote products 
+* derived from this software without specific prior written 
+* permission.
+* 
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS 
+* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT 
+* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS 
+* FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE 
+* COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, 
+* INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+* BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; 
+* LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+* CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, 
+* STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) 
+* ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF 
+* ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+* 
+*/
+
+// Include header
+#include "EmotivAnalyzer.h"
+
+// Constructor
+EmotivAnalyzer::EmotivAnalyzer()
+{
+	mFftTime = 0.0;
+	mReduceTime = 0.0;
+	mSampleRate = 128.0f;
+	mTimer.start();
+}
+
+// Average each band across channels
+void EmotivAnalyzer::averageBands( uint32_t numChannels )
+{
+	mBandPower.mNumChannels = numChannels;
+	for ( int32_t band = 0; band < EmotivBandPower::BAND_COUNT; band++ ) {
+		float sum = 0.0f;
+		for ( uint32_t channel = 0; channel < numChannels; channel++ ) {
+			sum += mBandPower.mChannels[ channel ][ band ];
+		}
+		mBandPower.mAverage[ band ] = numChannels > 0 ? sum / (float)numChannels : 0.0f;
+	}
+}
+
+// Set a channel's band value
+void EmotivAnalyzer::setBand( uint32_t channel, int32_t band, float value )
+{
+	if ( channel < EmotivBandPower::CHANNEL_COUNT ) {
+		mBandPower.mChannels[ channel ][ band ] = value;
+	}
+}
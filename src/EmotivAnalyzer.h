@@ -0,0 +1,107 @@
+/*
+* 
+* Copyright (c) 2012, Ban the Rewind
+* All rights reserved.
+* 
+* Redistribution and use in source and binary forms, with or 
+* without modification, are permitted provided that the following 
+* conditions are met:
+* 
+* Redistributions of source code must retain the above copyright 
+* notice, this list of conditions and the following disclaimer.
+* Redistributions in binary form must reproduce the above copyright 
+* notice, this list of conditions and the following disclaimer in 
+* the documentation and/or other materials provided with the 
+* distribution.
+* 
+* Neither the name of the Ban the Rewind nor the names of its 
+* contributors may be used to endorse or promote products 
+* derived from this software without specific prior written 
+* permission.
+* 
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS 
+* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT 
+* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS 
+* FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE 
+* COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, 
+* INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+* BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; 
+* LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+* CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, 
+* STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) 
+* ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF 
+* ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+* 
+*/
+
+#pragma once
+
+// Includes
+#include "cinder/Cinder.h"
+#include "cinder/Timer.h"
+#include "EmotivBands.h"
+#include "EmotivRingBuffer.h"
+#include "EmotivTaskPool.h"
+
+// Analyzer pointer alias
+typedef std::shared_ptr<class EmotivAnalyzer> EmotivAnalyzerRef;
+
+/*
+ * Base class for turning the raw EEG in a ring buffer into band 
+ * power. Block analyzers look at a window of samples at a time. 
+ * Streaming analyzers keep state across calls and take in every 
+ * new sample, so they can be run as often as samples arrive.
+ */
+class EmotivAnalyzer
+{
+
+public:
+
+	// Destructor
+	virtual ~EmotivAnalyzer() {}
+
+	// Analyzes samples of each channel up to, but not including, 
+	// sample index "end". Block analyzers use the "windowSize" 
+	// samples before it. Returns false if there was nothing to 
+	// analyze.
+	virtual bool				process( const EmotivRingBuffer &buffer, uint32_t windowSize, uint64_t end ) = 0;
+
+	// Returns true if results follow every sample rather than 
+	// a window
+	virtual bool				isStreaming() const { return false; }
+
+	// Sample rate of the incoming signal, used to place bands
+	float						getSampleRate() const { return mSampleRate; }
+	virtual void				setSampleRate( float sampleRate ) { mSampleRate = sampleRate; }
+
+	// Pool to spread channels across. Channels are processed on 
+	// the calling thread when this is empty.
+	const EmotivTaskPoolRef &	getTaskPool() const { return mTaskPool; }
+	void						setTaskPool( const EmotivTaskPoolRef &taskPool ) { mTaskPool = taskPool; }
+
+	// Results of the last pass
+	const EmotivBandPower &		getBandPower() const { return mBandPower; }
+
+	// Seconds the last pass spent transforming channels and 
+	// reducing them to bands
+	double						getFftTime() const { return mFftTime; }
+	double						getReduceTime() const { return mReduceTime; }
+
+protected:
+
+	// Constructor
+	EmotivAnalyzer();
+
+	// Sets one channel's band value. Call averageBands() once 
+	// all "numChannels" channels are set.
+	void						setBand( uint32_t channel, int32_t band, float value );
+	void						averageBands( uint32_t numChannels );
+
+	EmotivBandPower				mBandPower;
+	double						mFftTime;
+	double						mReduceTime;
+	float						mSampleRate;
+	EmotivTaskPoolRef			mTaskPool;
+	ci::Timer					mTimer;
+
+};
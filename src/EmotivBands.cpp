@@ -0,0 +1,156 @@
+/*
+* 
+* Copyright (c) 2012, Ban the Rewind
+* All rights reserved.
+* 
+* Redistribution and use in source and binary forms, with or 
+* without modification, are permitted provided that the following 
+* conditions are met:
+* 
+* Redistributions of source code must retain the above copyright 
+* notice, this list of conditions and the following disclaimer.
+* Redistributions in binary form must reproduce the above copyright 
+* notice, this list of conditions and the following disclaimer in 
+* the documentation and/or other materials provided with the 
+* distribution.
+* 
+* Neither the name of the Ban the Rewind nor the names of its 
+* contributors may be used to endorse or promote products 
+* derived from this software without specific prior written 
+* permission.
+* 
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS 
+* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT 
+* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS 
+* FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE 
+* COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, 
+* INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+* BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; 
+* LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+* CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, 
+* STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) 
+* ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF 
+* ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+* 
+*/
+
+// Include header
+#include "EmotivBands.h"
+#include <cmath>
+
+// Imports
+using namespace std;
+
+// At 128Hz with a one second window every bin is 1Hz wide
+static_assert( EmotivStaticBandTable<128, 128>::Range<EmotivBandPower::ALPHA>::BEGIN == 8, "Alpha should start at bin 8" );
+static_assert( EmotivStaticBandTable<128, 128>::Range<EmotivBandPower::ALPHA>::END == 13, "Alpha should end at bin 13" );
+static_assert( EmotivStaticBandTable<128, 128>::Range<EmotivBandPower::GAMMA>::END == 65, "Gamma should run to Nyquist" );
+
+// Two second windows double the resolution
+static_assert( EmotivStaticBandTable<128, 256>::Range<EmotivBandPower::ALPHA>::BEGIN == 16, "Alpha should start at bin 16" );
+static_assert( EmotivStaticBandTable<128, 256>::Range<EmotivBandPower::BETA>::END == 60, "Beta should end at bin 60" );
+
+// Band edges in Hz, indexed by band
+static const uint32_t BAND_LOW_HZ[ EmotivBandPower::BAND_COUNT ] = { 
+	EmotivBandEdges<EmotivBandPower::DELTA>::LOW, 
+	EmotivBandEdges<EmotivBandPower::THETA>::LOW, 
+	EmotivBandEdges<EmotivBandPower::ALPHA>::LOW, 
+	EmotivBandEdges<EmotivBandPower::BETA>::LOW, 
+	EmotivBandEdges<EmotivBandPower::GAMMA>::LOW
+};
+static const uint32_t BAND_HIGH_HZ[ EmotivBandPower::BAND_COUNT ] = { 
+	EmotivBandEdges<EmotivBandPower::DELTA>::HIGH, 
+	EmotivBandEdges<EmotivBandPower::THETA>::HIGH, 
+	EmotivBandEdges<EmotivBandPower::ALPHA>::HIGH, 
+	EmotivBandEdges<EmotivBandPower::BETA>::HIGH, 
+	EmotivBandEdges<EmotivBandPower::GAMMA>::HIGH
+};
+
+// Create empty table
+EmotivBandTable::EmotivBandTable()
+{
+	mBinCount = 0;
+	mFftSize = 0;
+	mSampleRate = 0.0f;
+	for ( int32_t band = 0; band < EmotivBandPower::BAND_COUNT; band++ ) {
+		mBegin[ band ] = 0;
+		mEnd[ band ] = 0;
+		mScale[ band ] = 0.0f;
+	}
+}
+
+// Build table from band edges
+EmotivBandTable::EmotivBandTable( float sampleRate, uint32_t fftSize, uint32_t binCount )
+{
+
+	// Set properties
+	mBinCount = binCount;
+	mFftSize = fftSize;
+	mSampleRate = sampleRate;
+
+	// Convert each band's edges to bins, rounding up
+	float binsPerHz = sampleRate > 0.0f ? (float)fftSize / sampleRate : 0.0f;
+	for ( int32_t band = 0; band < EmotivBandPower::BAND_COUNT; band++ ) {
+		uint32_t begin = static_cast<uint32_t>( ceil( (float)BAND_LOW_HZ[ band ] * binsPerHz ) );
+		uint32_t end = BAND_HIGH_HZ[ band ] == 0 ? binCount : static_cast<uint32_t>( ceil( (float)BAND_HIGH_HZ[ band ] * binsPerHz ) );
+		setRange( band, begin, end );
+	}
+
+}
+
+// Set band range
+void EmotivBandTable::setRange( int32_t band, uint32_t begin, uint32_t end )
+{
+
+	// Keep inside the spectrum. A band narrower than one 
+	// bin still gets the bin it falls in.
+	end = min( end, mBinCount );
+	begin = min( begin, end );
+	if ( begin == end && end < mBinCount ) {
+		end++;
+	}
+
+	// Store range and averaging factor
+	mBegin[ band ] = begin;
+	mEnd[ band ] = end;
+	mScale[ band ] = end > begin ? 1.0f / (float)( end - begin ) : 0.0f;
+
+}
+
+// Find band by frequency
+int32_t getEmotivBand( float frequency )
+{
+	for ( int32_t band = EmotivBandPower::BAND_COUNT - 1; band >= 0; band-- ) {
+		if ( frequency >= (float)BAND_LOW_HZ[ band ] ) {
+			return band;
+		}
+	}
+	return -1;
+}
+
+// Get upper band edge
+float getEmotivBandHigh( int32_t band, float sampleRate )
+{
+	return BAND_HIGH_HZ[ band ] == 0 ? sampleRate * 0.5f : (float)BAND_HIGH_HZ[ band ];
+}
+
+// Get lower band edge
+float getEmotivBandLow( int32_t band )
+{
+	return (float)BAND_LOW_HZ[ band ];
+}
+
+// Get table for sample rate and FFT size
+EmotivBandTable getEmotivBandTable( float sampleRate, uint32_t fftSize, uint32_t binCount )
+{
+	if ( sampleRate == 128.0f ) {
+		if ( fftSize == 128 ) {
+			return EmotivStaticBandTable<128, 128>::create( binCount );
+		} else if ( fftSize == 256 ) {
+			return EmotivStaticBandTable<128, 256>::create( binCount );
+		} else if ( fftSize == 512 ) {
+			return EmotivStaticBandTable<128, 512>::create( binCount );
+		}
+	}
+	return EmotivBandTable( sampleRate, fftSize, binCount );
+}
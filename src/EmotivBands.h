@@ -0,0 +1,197 @@
+/*
+* 
+* Copyright (c) 2012, Ban the Rewind
+* All rights reserved.
+* 
+* Redistribution and use in source and binary forms, with or 
+* without modification, are permitted provided that the following 
+* conditions are met:
+* 
+* Redistributions of source code must retain the above copyright 
+* notice, this list of conditions and the following disclaimer.
+* Redistributions in binary form must reproduce the above copyright 
+* notice, this list of conditions and the following disclaimer in 
+* the documentation and/or other materials provided with the 
+* distribution.
+* 
+* Neither the name of the Ban the Rewind nor the names of its 
+* contributors may be used to endorse or promote products 
+* derived from this software without specific prior written 
+* permission.
+* 
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS 
+* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT 
+* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS 
+* FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE 
+* COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, 
+* INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+* BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; 
+* LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+* CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, 
+* STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) 
+* ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF 
+* ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+* 
+*/
+
+#pragma once
+
+// Includes
+#include "cinder/Cinder.h"
+#include <cstring>
+
+// Brainwave band power per EEG channel, and averaged across channels
+class EmotivBandPower
+{
+
+public:
+
+	// Band indices
+	static const int32_t DELTA =			0;
+	static const int32_t THETA =			1;
+	static const int32_t ALPHA =			2;
+	static const int32_t BETA =				3;
+	static const int32_t GAMMA =			4;
+	static const int32_t BAND_COUNT =		5;
+
+	// Maximum number of channels stored
+	static const int32_t CHANNEL_COUNT =	14;
+
+	// Constructor
+	EmotivBandPower( uint32_t userId = 0x00 )
+	{
+		memset( mAverage, 0, sizeof( mAverage ) );
+		memset( mChannels, 0, sizeof( mChannels ) );
+		mNumChannels = 0;
+		mUserId = userId;
+	}
+
+	// Getters
+	float		getAverage( int32_t band ) const { return mAverage[ band ]; }
+	float		getChannel( int32_t channel, int32_t band ) const { return mChannels[ channel ][ band ]; }
+	uint32_t	getNumChannels() const { return mNumChannels; }
+	uint32_t	getUserId() const { return mUserId; }
+
+private:
+
+	// Band values
+	float		mAverage[ BAND_COUNT ];
+	float		mChannels[ CHANNEL_COUNT ][ BAND_COUNT ];
+	uint32_t	mNumChannels;
+	uint32_t	mUserId;
+
+	friend class Emotiv;
+	friend class EmotivAnalyzer;
+
+};
+
+/*
+ * Brainwave band edges in Hz. Each band covers [ LOW, HIGH ).
+ * A HIGH of zero means the band runs up to the Nyquist frequency.
+ */
+template<int32_t Band> struct EmotivBandEdges;
+template<> struct EmotivBandEdges<EmotivBandPower::DELTA>	{ static const uint32_t LOW = 1;	static const uint32_t HIGH = 4; };
+template<> struct EmotivBandEdges<EmotivBandPower::THETA>	{ static const uint32_t LOW = 4;	static const uint32_t HIGH = 8; };
+template<> struct EmotivBandEdges<EmotivBandPower::ALPHA>	{ static const uint32_t LOW = 8;	static const uint32_t HIGH = 13; };
+template<> struct EmotivBandEdges<EmotivBandPower::BETA>	{ static const uint32_t LOW = 13;	static const uint32_t HIGH = 30; };
+template<> struct EmotivBandEdges<EmotivBandPower::GAMMA>	{ static const uint32_t LOW = 30;	static const uint32_t HIGH = 0; };
+
+/*
+ * Bin ranges of each band for one sample rate and FFT size.
+ * Summing bins [ getBegin( band ), getEnd( band ) ) and multiplying 
+ * by getScale( band ) gives the band's mean amplitude.
+ */
+class EmotivBandTable
+{
+
+public:
+
+	// Creates an empty table
+	EmotivBandTable();
+
+	// Builds the table for an FFT of "fftSize" samples at "sampleRate". 
+	// "binCount" is the number of bins the FFT produces.
+	EmotivBandTable( float sampleRate, uint32_t fftSize, uint32_t binCount );
+
+	// Getters
+	uint32_t	getBegin( int32_t band ) const { return mBegin[ band ]; }
+	uint32_t	getBinCount() const { return mBinCount; }
+	uint32_t	getEnd( int32_t band ) const { return mEnd[ band ]; }
+	uint32_t	getFftSize() const { return mFftSize; }
+	float		getSampleRate() const { return mSampleRate; }
+	float		getScale( int32_t band ) const { return mScale[ band ]; }
+
+	// Returns true if the table was built for these parameters
+	bool		matches( float sampleRate, uint32_t fftSize, uint32_t binCount ) const 
+	{ 
+		return mSampleRate == sampleRate && mFftSize == fftSize && mBinCount == binCount; 
+	}
+
+	// Sets a band's bins, clamped to the bin count
+	void		setRange( int32_t band, uint32_t begin, uint32_t end );
+
+private:
+
+	uint32_t	mBegin[ EmotivBandPower::BAND_COUNT ];
+	uint32_t	mBinCount;
+	uint32_t	mEnd[ EmotivBandPower::BAND_COUNT ];
+	uint32_t	mFftSize;
+	float		mSampleRate;
+	float		mScale[ EmotivBandPower::BAND_COUNT ];
+
+};
+
+/*
+ * Band table computed at compile time for a fixed sample rate and 
+ * FFT size. Range<Band>::BEGIN and Range<Band>::END give the bins, 
+ * create() turns them into a regular table.
+ */
+template<uint32_t SampleRate, uint32_t FftSize>
+class EmotivStaticBandTable
+{
+
+public:
+
+	// Bins in a real FFT of this size
+	static const uint32_t BIN_COUNT = FftSize / 2 + 1;
+
+	// First bin at or above "hz", rounding up
+	template<uint32_t Hz> struct Bin
+	{
+		static const uint32_t VALUE = ( Hz * FftSize + SampleRate - 1 ) / SampleRate;
+	};
+
+	// Bin range of a band
+	template<int32_t Band> struct Range
+	{
+		static const uint32_t BEGIN = Bin<EmotivBandEdges<Band>::LOW>::VALUE;
+		static const uint32_t END	= EmotivBandEdges<Band>::HIGH == 0 || Bin<EmotivBandEdges<Band>::HIGH>::VALUE > BIN_COUNT ? 
+			BIN_COUNT : Bin<EmotivBandEdges<Band>::HIGH>::VALUE;
+	};
+
+	// Create runtime table
+	static EmotivBandTable create( uint32_t binCount = BIN_COUNT )
+	{
+		EmotivBandTable table( (float)SampleRate, FftSize, binCount );
+		table.setRange( EmotivBandPower::DELTA, Range<EmotivBandPower::DELTA>::BEGIN, Range<EmotivBandPower::DELTA>::END );
+		table.setRange( EmotivBandPower::THETA, Range<EmotivBandPower::THETA>::BEGIN, Range<EmotivBandPower::THETA>::END );
+		table.setRange( EmotivBandPower::ALPHA, Range<EmotivBandPower::ALPHA>::BEGIN, Range<EmotivBandPower::ALPHA>::END );
+		table.setRange( EmotivBandPower::BETA,	Range<EmotivBandPower::BETA>::BEGIN,	Range<EmotivBandPower::BETA>::END );
+		table.setRange( EmotivBandPower::GAMMA, Range<EmotivBandPower::GAMMA>::BEGIN, Range<EmotivBandPower::GAMMA>::END );
+		return table;
+	}
+
+};
+
+// Returns the band a frequency in Hz falls in, or -1 if it is 
+// below the lowest band
+int32_t getEmotivBand( float frequency );
+
+// Returns a band's edges in Hz. A band running up to Nyquist 
+// gets half of "sampleRate" as its high edge.
+float getEmotivBandHigh( int32_t band, float sampleRate );
+float getEmotivBandLow( int32_t band );
+
+// Returns the band table for a sample rate and FFT size. Common 
+// EPOC sizes come from compile-time tables, others are computed.
+EmotivBandTable getEmotivBandTable( float sampleRate, uint32_t fftSize, uint32_t binCount );
@@ -0,0 +1,322 @@
+/*
+* 
+* Copyright (c) 2012, Ban the Rewind
+* All rights reserved.
+* 
+* Redistribution and use in source and binary forms, with or 
+* without modification, are permitted provided that the following 
+* conditions are met:
+* 
+* Redistributions of source code must retain the above copyright 
+* notice, this list of conditions and the following disclaimer.
+* Redistributions in binary form must reproduce the above copyright 
+* notice, this list of conditions and the following disclaimer in 
+* the documentation and/or other materials provided with the 
+* distribution.
+* 
+* Neither the name of the Ban the Rewind nor the names of its 
+* contributors may be used to endorse or promote products 
+* derived from this software without specific prior written 
+* permission.
+* 
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS 
+* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT 
+* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS 
+* FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE 
+* COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, 
+* INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+* BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; 
+* LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+* CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, 
+* STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) 
+* ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF 
+* ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+* 
+*/
+
+// Include header
+#include "EmotivEdkEngine.h"
+
+#ifndef EMOTIV_NO_EDK
+
+// Imports
+using namespace ci;
+using namespace std;
+
+// Number of Expressiv action flags (EXP_NEUTRAL through EXP_SMIRK_RIGHT)
+static const int32_t EXPRESSIV_COUNT = 12;
+
+// Maps an Expressiv action flag to its bit position
+static int32_t getExpressivIndex( EE_ExpressivAlgo_t action )
+{
+	int32_t index = 0;
+	for ( uint32_t flag = static_cast<uint32_t>( action ); flag > 1 && index < EXPRESSIV_COUNT - 1; flag >>= 1 ) {
+		index++;
+	}
+	return index;
+}
+
+// Create pointer to EDK engine
+EmotivEdkEngineRef EmotivEdkEngine::create()
+{
+	return EmotivEdkEngineRef( new EmotivEdkEngine() );
+}
+
+// Constructor
+EmotivEdkEngine::EmotivEdkEngine()
+{
+
+	// Set up target channel list. The EEG channels come first 
+	// so they line up with the raw buffer's channel order.
+	mTargetChannelList[ 0 ] = ED_AF3;
+	mTargetChannelList[ 1 ] = ED_F7;
+	mTargetChannelList[ 2 ] = ED_F3;
+	mTargetChannelList[ 3 ] = ED_FC5;
+	mTargetChannelList[ 4 ] = ED_T7;
+	mTargetChannelList[ 5 ] = ED_P7;
+	mTargetChannelList[ 6 ] = ED_O1;
+	mTargetChannelList[ 7 ] = ED_O2;
+	mTargetChannelList[ 8 ] = ED_P8;
+	mTargetChannelList[ 9 ] = ED_T8;
+	mTargetChannelList[ 10 ] = ED_FC6;
+	mTargetChannelList[ 11 ] = ED_F4;
+	mTargetChannelList[ 12 ] = ED_F8;
+	mTargetChannelList[ 13 ] = ED_AF4;
+	mTargetChannelList[ 14 ] = ED_COUNTER;
+	mTargetChannelList[ 15 ] = ED_GYROX;
+	mTargetChannelList[ 16 ] = ED_GYROY;
+	mTargetChannelList[ 17 ] = ED_TIMESTAMP;
+	mTargetChannelList[ 18 ] = ED_FUNC_ID;
+	mTargetChannelList[ 19 ] = ED_FUNC_VALUE;
+	mTargetChannelList[ 20 ] = ED_MARKER;
+	mTargetChannelList[ 21 ] = ED_SYNC_SIGNAL;
+
+	// Initialize state
+	mConnected = false;
+	mEvent = 0;
+	mState = 0;
+
+}
+
+// Destructor
+EmotivEdkEngine::~EmotivEdkEngine()
+{
+	if ( mConnected ) {
+		disconnect();
+	}
+}
+
+// Connect to Emotiv Engine
+bool EmotivEdkEngine::connect( const string &deviceId, const string &remoteAddress, uint16_t port )
+{
+
+	try {
+
+		// Connect to remote engine or composer or the local Emotiv Engine
+		if ( remoteAddress.length() > 0 && port > 0 ) {
+			mConnected = EE_EngineRemoteConnect( remoteAddress.c_str(), port, deviceId.c_str() ) == EDK_OK;
+		} else {
+			mConnected = EE_EngineConnect( deviceId.c_str() ) == EDK_OK;
+		}
+
+		// Connected
+		if ( mConnected ) {
+
+			// Add event listening
+			mEvent = EE_EmoEngineEventCreate();
+			mState = EE_EmoStateCreate();
+
+		}
+
+	} catch ( ... ) {
+
+		// Disconnect if routine fails
+		mConnected = false;
+
+	}
+
+	// Return connected flag
+	return mConnected;
+
+}
+
+// Disconnect from Emotiv Engine
+bool EmotivEdkEngine::disconnect()
+{
+
+	// Disconnect and free resources
+	try {
+		if ( EE_EngineDisconnect() != EDK_OK ) {
+			return false;
+		}
+		EE_EmoStateFree( mState );
+		EE_EmoEngineEventFree( mEvent );
+		for ( map<uint32_t, DataHandle>::iterator dataIt = mData.begin(); dataIt != mData.end(); ++dataIt ) {
+			EE_DataFree( dataIt->second );
+		}
+		mData.clear();
+		mConnected = false;
+		return true;
+	} catch ( ... ) {
+		return false;
+	}
+
+}
+
+// Free a removed user's data handle
+void EmotivEdkEngine::disableData( uint32_t userId )
+{
+	map<uint32_t, DataHandle>::iterator dataIt = mData.find( userId );
+	if ( dataIt != mData.end() ) {
+		EE_DataFree( dataIt->second );
+		mData.erase( dataIt );
+	}
+}
+
+// Enable data acquisition for a new user and give them a data handle
+uint32_t EmotivEdkEngine::enableData( uint32_t userId )
+{
+	if ( mData.find( userId ) == mData.end() ) {
+		mData[ userId ] = EE_DataCreate();
+	}
+	EE_DataAcquisitionEnable( userId, true );
+	uint32_t sampleRate = 0;
+	if ( EE_DataGetSamplingRate( userId, &sampleRate ) != EDK_OK ) {
+		return 0;
+	}
+	return sampleRate;
+}
+
+// Copy latched samples of an EEG channel
+void EmotivEdkEngine::getData( uint32_t userId, int32_t channel, double * dest, uint32_t count )
+{
+	map<uint32_t, DataHandle>::iterator dataIt = mData.find( userId );
+	if ( dataIt != mData.end() ) {
+		EE_DataChannel_t target = channel == CHANNEL_TIMESTAMP ? ED_TIMESTAMP : mTargetChannelList[ channel ];
+		EE_DataGet( dataIt->second, target, dest, count );
+	}
+}
+
+// Read next engine event
+int32_t EmotivEdkEngine::getNextEvent( uint32_t &userId, EmotivEvent &event )
+{
+
+	// Get event
+	int32_t eventId = EDK_NO_EVENT;
+	try {
+		eventId = EE_EngineGetNextEvent( mEvent );
+	} catch ( ... ) {
+	}
+
+	// Verify event
+	if ( eventId != EDK_OK ) {
+		return EVENT_NONE;
+	}
+
+	// Get user ID
+	if ( EE_EmoEngineEventGetUserId( mEvent, &userId ) != EDK_OK ) {
+		return EVENT_OTHER;
+	}
+
+	// Get event type
+	EE_Event_t eventType = EE_EmoEngineEventGetType( mEvent );
+	if ( eventType == EE_UserAdded ) {
+		return EVENT_USER_ADDED;
+	}
+	if ( eventType == EE_UserRemoved ) {
+		return EVENT_USER_REMOVED;
+	}
+	if ( eventType != EE_EmoStateUpdated ) {
+		return EVENT_OTHER;
+	}
+
+	// Get Emotiv state
+	EE_EmoEngineEventGetEmoState( mEvent, mState );
+	if ( mState == 0 ) {
+		return EVENT_OTHER;
+	}
+
+	// Collect Expressiv Suite results by action
+	float expressivStates[ EXPRESSIV_COUNT ] = { 0.0f };
+	expressivStates[ getExpressivIndex( ES_ExpressivGetUpperFaceAction( mState ) ) ] = ES_ExpressivGetUpperFaceActionPower( mState );
+	expressivStates[ getExpressivIndex( ES_ExpressivGetLowerFaceAction( mState ) ) ] = ES_ExpressivGetLowerFaceActionPower( mState );
+
+	// Build event from state
+	event = EmotivEvent(
+		ES_GetTimeFromStart( mState ), 
+		userId, 
+		static_cast<int32_t>( ES_GetWirelessSignalStatus( mState ) ), 
+		ES_ExpressivIsBlink( mState ), 
+		ES_ExpressivIsLeftWink( mState ), 
+		ES_ExpressivIsRightWink( mState ), 
+		ES_ExpressivIsLookingLeft( mState ), 
+		ES_ExpressivIsLookingRight( mState ), 
+		expressivStates[ getExpressivIndex( EXP_EYEBROW ) ], 
+		expressivStates[ getExpressivIndex( EXP_FURROW ) ], 
+		expressivStates[ getExpressivIndex( EXP_SMILE ) ], 
+		expressivStates[ getExpressivIndex( EXP_CLENCH ) ], 
+		expressivStates[ getExpressivIndex( EXP_SMIRK_LEFT ) ], 
+		expressivStates[ getExpressivIndex( EXP_SMIRK_RIGHT ) ], 
+		expressivStates[ getExpressivIndex( EXP_LAUGH ) ], 
+		ES_AffectivGetExcitementShortTermScore( mState ), 
+		ES_AffectivGetExcitementLongTermScore( mState ), 
+		ES_AffectivGetEngagementBoredomScore( mState ), 
+		static_cast<int32_t>( ES_CognitivGetCurrentAction( mState ) ), 
+		ES_CognitivGetCurrentActionPower( mState )
+		);
+	return EVENT_STATE_UPDATED;
+
+}
+
+// Get number of connected devices
+uint32_t EmotivEdkEngine::getNumUsers()
+{
+
+	// Retrieve and return number of connected headsets
+	uint32_t users = 0;
+	EE_EngineGetNumUser( &users );
+	return users;
+
+}
+
+// Load profile onto device
+bool EmotivEdkEngine::loadProfile( const fs::path &profilePath, uint32_t userId )
+{
+
+	// Bail if not connected
+	if ( !mConnected ) {
+		return false;
+	}
+
+	// Load profile
+	try {
+		if ( EE_LoadUserProfile( userId, profilePath.generic_string().c_str() ) != EDK_OK ) {
+			return false;
+		}
+		return true;
+	} catch ( ... ) {
+		return false;
+	}
+
+}
+
+// Set engine-side buffer size
+void EmotivEdkEngine::setDataBufferSize( double seconds )
+{
+	EE_DataSetBufferSizeInSec( (float)seconds );
+}
+
+// Latch new samples for a user
+uint32_t EmotivEdkEngine::updateData( uint32_t userId )
+{
+	map<uint32_t, DataHandle>::iterator dataIt = mData.find( userId );
+	if ( dataIt == mData.end() ) {
+		return 0;
+	}
+	EE_DataUpdateHandle( userId, dataIt->second );
+	uint32_t samplesTaken = 0;
+	EE_DataGetNumberOfSample( dataIt->second, &samplesTaken );
+	return samplesTaken;
+}
+
+#endif
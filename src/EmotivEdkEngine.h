@@ -0,0 +1,94 @@
+/*
+* 
+* Copyright (c) 2012, Ban the Rewind
+* All rights reserved.
+* 
+* Redistribution and use in source and binary forms, with or 
+* without modification, are permitted provided that the following 
+* conditions are met:
+* 
+* Redistributions of source code must retain the above copyright 
+* notice, this list of conditions and the following disclaimer.
+* Redistributions in binary form must reproduce the above copyright 
+* notice, this list of conditions and the following disclaimer in 
+* the documentation and/or other materials provided with the 
+* distribution.
+* 
+* Neither the name of the Ban the Rewind nor the names of its 
+* contributors may be used to endorse or promote products 
+* derived from this software without specific prior written 
+* permission.
+* 
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS 
+* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT 
+* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS 
+* FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE 
+* COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, 
+* INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+* BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; 
+* LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+* CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, 
+* STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) 
+* ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF 
+* ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+* 
+*/
+
+#pragma once
+
+// The EDK engine is left out of builds without the Emotiv SDK
+#ifndef EMOTIV_NO_EDK
+
+// Includes
+#include "emotiv/EmoStateDLL.h"
+#include "emotiv/edk.h"
+#include "emotiv/edkErrorCode.h"
+#include "EmotivEngine.h"
+#include <map>
+
+// EDK engine pointer alias
+typedef std::shared_ptr<class EmotivEdkEngine> EmotivEdkEngineRef;
+
+// Engine backed by the Emotiv EDK
+class EmotivEdkEngine : public EmotivEngine
+{
+
+public:
+
+	// Create pointer to EDK engine
+	static EmotivEdkEngineRef	create();
+
+	// Destructor
+	~EmotivEdkEngine();
+
+	// EmotivEngine
+	bool		connect( const std::string &deviceId, const std::string &remoteAddress, uint16_t port );
+	void		disableData( uint32_t userId );
+	bool		disconnect();
+	uint32_t	enableData( uint32_t userId );
+	void		getData( uint32_t userId, int32_t channel, double * dest, uint32_t count );
+	int32_t		getNextEvent( uint32_t &userId, EmotivEvent &event );
+	uint32_t	getNumUsers();
+	bool		loadProfile( const ci::fs::path &profilePath, uint32_t userId );
+	void		setDataBufferSize( double seconds );
+	uint32_t	updateData( uint32_t userId );
+
+private:
+
+	// Constructor
+	EmotivEdkEngine();
+
+	// Connected status
+	bool					mConnected;
+
+	// Event handlers
+	EmoEngineEventHandle	mEvent;
+	EmoStateHandle			mState;
+
+	// Raw EEG data handles by user ID
+	std::map<uint32_t, DataHandle>	mData;
+	EE_DataChannel_t				mTargetChannelList[ 22 ];
+
+};
+
+#endif
@@ -0,0 +1,118 @@
+/*
+* 
+* Copyright (c) 2012, Ban the Rewind
+* All rights reserved.
+* 
+* Redistribution and use in source and binary forms, with or 
+* without modification, are permitted provided that the following 
+* conditions are met:
+* 
+* Redistributions of source code must retain the above copyright 
+* notice, this list of conditions and the following disclaimer.
+* Redistributions in binary form must reproduce the above copyright 
+* notice, this list of conditions and the following disclaimer in 
+* the documentation and/or other materials provided with the 
+* distribution.
+* 
+* Neither the name of the Ban the Rewind nor the names of its 
+* contributors may be used to endorse or promote products 
+* derived from this software without specific prior written 
+* permission.
+* 
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS 
+* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT 
+* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS 
+* FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE 
+* COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, 
+* INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+* BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; 
+* LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+* CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, 
+* STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) 
+* ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF 
+* ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+* 
+*/
+
+#pragma once
+
+// Includes
+#include "cinder/Cinder.h"
+#include "EmotivEvent.h"
+#include <string>
+
+// Engine pointer alias
+typedef std::shared_ptr<class EmotivEngine> EmotivEngineRef;
+
+/*
+ * Source of engine events and raw EEG behind Emotiv. EmotivEdkEngine 
+ * talks to the Emotiv EDK and EmotivSimulator generates synthetic 
+ * data, so the rest of the library runs without a headset. All 
+ * methods except connect() and disconnect() are called from the 
+ * acquisition thread.
+ */
+class EmotivEngine
+{
+
+public:
+
+	// Event types returned by getNextEvent()
+	static const int32_t EVENT_NONE =			0;
+	static const int32_t EVENT_USER_ADDED =		1;
+	static const int32_t EVENT_USER_REMOVED =	2;
+	static const int32_t EVENT_STATE_UPDATED =	3;
+	static const int32_t EVENT_OTHER =			4;
+	static const int32_t EVENT_TYPE_COUNT =		5;
+
+	// Number of EEG channels returned by getData()
+	static const int32_t EEG_CHANNEL_COUNT =	14;
+
+	// getData() channel holding the headset's packet counter, 
+	// which counts from 0 to COUNTER_RANGE - 1 and wraps
+	static const int32_t CHANNEL_COUNTER =		14;
+	static const int32_t COUNTER_RANGE =		128;
+
+	// getData() channel holding the time each sample was taken, 
+	// in seconds on the headset's or engine's clock
+	static const int32_t CHANNEL_TIMESTAMP =	15;
+
+	// Destructor
+	virtual ~EmotivEngine() {}
+
+	// Dis/connect. "deviceId", "remoteAddress" and "port" are only 
+	// meaningful to engines that talk to hardware.
+	virtual bool		connect( const std::string &deviceId, const std::string &remoteAddress, uint16_t port ) = 0;
+	virtual bool		disconnect() = 0;
+
+	// Number of connected users
+	virtual uint32_t	getNumUsers() = 0;
+
+	// Loads a user profile. Engines without profiles return false.
+	virtual bool		loadProfile( const ci::fs::path &profilePath, uint32_t userId ) = 0;
+
+	// Reads the next event, returning its type or EVENT_NONE if there 
+	// is none. "userId" is set for every event. "event" is filled in 
+	// for EVENT_STATE_UPDATED, leaving the brainwave fields at zero.
+	virtual int32_t		getNextEvent( uint32_t &userId, EmotivEvent &event ) = 0;
+
+	// Starts raw data acquisition for a newly added user. Returns 
+	// the user's sample rate, or zero if it is unknown.
+	virtual uint32_t	enableData( uint32_t userId ) = 0;
+
+	// Releases a removed user's raw data resources
+	virtual void		disableData( uint32_t userId ) = 0;
+
+	// Seconds of raw data the engine keeps between updateData() calls
+	virtual void		setDataBufferSize( double seconds ) = 0;
+
+	// Takes the samples received for a user since the last call and 
+	// returns how many there are. getData() then copies "count" of 
+	// that user's samples from EEG channel "channel" (0 to 
+	// EEG_CHANNEL_COUNT - 1, in the order AF3, F7, F3, FC5, T7, P7, 
+	// O1, O2, P8, T8, FC6, F4, F8, AF4), CHANNEL_COUNTER or 
+	// CHANNEL_TIMESTAMP into "dest". Each user's samples are kept 
+	// until their next updateData() call.
+	virtual uint32_t	updateData( uint32_t userId ) = 0;
+	virtual void		getData( uint32_t userId, int32_t channel, double * dest, uint32_t count ) = 0;
+
+};
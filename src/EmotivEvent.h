@@ -0,0 +1,212 @@
+/*
+* 
+* Copyright (c) 2012, Ban the Rewind
+* All rights reserved.
+* 
+* Redistribution and use in source and binary forms, with or 
+* without modification, are permitted provided that the following 
+* conditions are met:
+* 
+* Redistributions of source code must retain the above copyright 
+* notice, this list of conditions and the following disclaimer.
+* Redistributions in binary form must reproduce the above copyright 
+* notice, this list of conditions and the following disclaimer in 
+* the documentation and/or other materials provided with the 
+* distribution.
+* 
+* Neither the name of the Ban the Rewind nor the names of its 
+* contributors may be used to endorse or promote products 
+* derived from this software without specific prior written 
+* permission.
+* 
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS 
+* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT 
+* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS 
+* FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE 
+* COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, 
+* INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+* BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; 
+* LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+* CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, 
+* STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) 
+* ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF 
+* ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+* 
+*/
+
+#pragma once
+
+// Includes
+#include "boost/type_traits/has_trivial_copy.hpp"
+#include "boost/type_traits/has_trivial_destructor.hpp"
+#include "cinder/Cinder.h"
+#include <cstddef>
+#include <type_traits>
+
+/*
+ * Emotiv event. A fixed-layout, trivially copyable record of 
+ * 84 bytes, so it can be copied with memcpy, recorded to disk 
+ * and shared across processes as is. The on/off expressiv 
+ * states are packed as bit fields. Callbacks receive it by 
+ * const reference.
+ */
+class EmotivEvent
+{
+
+private:
+
+	// Event properties
+	float					mTime;
+	uint32_t				mUserId;
+	int32_t					mWirelessSignalStatus;
+	uint32_t				mBlink		: 1;
+	uint32_t				mWinkLeft	: 1;
+	uint32_t				mWinkRight	: 1;
+	uint32_t				mLookLeft	: 1;
+	uint32_t				mLookRight	: 1;
+	uint32_t				mReserved	: 27;
+	float					mEyebrow;
+	float					mFurrow;
+	float					mSmile;
+	float					mClench;
+	float					mSmirkLeft;
+	float					mSmirkRight;
+	float					mLaugh;
+	float					mShortTermExcitement;
+	float					mLongTermExcitement;
+	float					mEngagementBoredom;
+	int32_t					mCognitivAction;
+	float					mCognitivPower;
+	float					mAlpha;
+	float					mBeta;
+	float					mDelta;
+	float					mGamma;
+	float					mTheta;
+
+	friend class			Emotiv;
+	friend struct			EmotivEventLayout;
+
+public:
+
+	// Wireless signal constants. These and the cognitive action 
+	// constants use the EDK's values, so this header does not 
+	// need to include it.
+	static const int32_t BAD_SIGNAL =					1;
+	static const int32_t GOOD_SIGNAL =					2;
+	static const int32_t NO_SIGNAL =					0;
+
+	// Cognitive action constants
+	static const int32_t COG_DISAPPEAR =				0x2000;
+	static const int32_t COG_DROP =						0x0010;
+	static const int32_t COG_LEFT =						0x0020;
+	static const int32_t COG_LIFT =						0x0008;
+	static const int32_t COG_NEUTRAL =					0x0001;
+	static const int32_t COG_PULL =						0x0004;
+	static const int32_t COG_PUSH =						0x0002;
+	static const int32_t COG_RIGHT =					0x0040;
+	static const int32_t COG_ROTATE_CLOCKWISE =			0x0200;
+	static const int32_t COG_ROTATE_COUNTER_CLOCKWISE =	0x0400;
+	static const int32_t COG_ROTATE_FORWARDS =			0x0800;
+	static const int32_t COG_ROTATE_LEFT =				0x0080;
+	static const int32_t COG_ROTATE_REVERSE =			0x1000;
+	static const int32_t COG_ROTATE_RIGHT =				0x0100;
+
+	// Constructor. There is no destructor, so copies stay trivial.
+	EmotivEvent(
+		float time = 0.0f, 
+		uint32_t userId = 0x00, 
+		int32_t wirelessSignalStatus = NO_SIGNAL, 
+		int32_t blink = 0, 
+		int32_t winkLeft = 0, 
+		int32_t winkRight = 0, 
+		int32_t lookLeft = 0, 
+		int32_t lookRight = 0, 
+		float eyebrow = 0.0f, 
+		float furrow = 0.0f, 
+		float smile = 0.0f, 
+		float clench = 0.0f, 
+		float smirkLeft = 0.0f, 
+		float smirkRight = 0.0f, 
+		float laugh = 0.0f, 
+		float shortTermExcitement = 0.0f, 
+		float longTermExcitement = 0.0f, 
+		float engagementBoredom = 0.0f, 
+		int32_t cognitivAction = COG_NEUTRAL, 
+		float cognitivPower = 0.0f, 
+		float alpha = 0.0f, 
+		float beta = 0.0f, 
+		float delta = 0.0f, 
+		float gamma = 0.0f, 
+		float theta = 0.0f
+		) 
+	{
+		mAlpha = alpha;
+		mBeta = beta;
+		mBlink = blink != 0;
+		mClench = clench;
+		mCognitivAction = cognitivAction;
+		mCognitivPower = cognitivPower;
+		mDelta = delta;
+		mEngagementBoredom = engagementBoredom;
+		mEyebrow = eyebrow;
+		mFurrow = furrow;
+		mGamma = gamma;
+		mLaugh = laugh;
+		mLongTermExcitement = longTermExcitement;
+		mLookLeft = lookLeft != 0;
+		mLookRight = lookRight != 0;
+		mReserved = 0;
+		mShortTermExcitement = shortTermExcitement;
+		mSmile = smile;
+		mSmirkLeft = smirkLeft;
+		mSmirkRight = smirkRight;
+		mTheta = theta;
+		mTime = time;
+		mUserId = userId;
+		mWinkLeft = winkLeft != 0;
+		mWinkRight = winkRight != 0;
+		mWirelessSignalStatus = wirelessSignalStatus;
+	}
+
+	// Getters
+	float		getTime() const { return mTime; }
+	uint32_t	getUserId() const { return mUserId; }
+	int32_t		getWirelessSignalStatus() const { return mWirelessSignalStatus; }
+	int32_t		getBlink() const { return static_cast<int32_t>( mBlink ); }
+	int32_t		getWinkLeft() const { return static_cast<int32_t>( mWinkLeft ); }
+	int32_t		getWinkRight() const { return static_cast<int32_t>( mWinkRight ); }
+	int32_t		getLookLeft() const { return static_cast<int32_t>( mLookLeft ); }
+	int32_t		getLookRight() const { return static_cast<int32_t>( mLookRight ); }
+	float		getEyebrow() const { return mEyebrow; }
+	float		getFurrow() const { return mFurrow; }
+	float		getSmile() const { return mSmile; }
+	float		getClench() const { return mClench; }
+	float		getSmirkLeft() const { return mSmirkLeft; }
+	float		getSmirkRight() const { return mSmirkRight; }
+	float		getLaugh() const { return mLaugh; }
+	float		getShortTermExcitement() const { return mShortTermExcitement; }
+	float		getLongTermExcitement() const { return mLongTermExcitement; }
+	float		getEngagementBoredom() const { return mEngagementBoredom; }
+	int32_t		getCognitivAction() const { return mCognitivAction; }
+	float		getCognitivPower() const { return mCognitivPower; }
+	float		getAlpha() const { return mAlpha; }
+	float		getBeta() const { return mBeta; }
+	float		getDelta() const { return mDelta; }
+	float		getGamma() const { return mGamma; }
+	float		getTheta() const { return mTheta; }
+
+};
+
+// Recordings and other processes read events byte for byte, so 
+// any change to this layout must bump EmotivRecorder::VERSION
+struct EmotivEventLayout
+{
+	static_assert( boost::has_trivial_copy<EmotivEvent>::value, "EmotivEvent must be trivially copyable" );
+	static_assert( boost::has_trivial_destructor<EmotivEvent>::value, "EmotivEvent must be trivially destructible" );
+	static_assert( std::is_standard_layout<EmotivEvent>::value, "EmotivEvent must be standard-layout for offsetof" );
+	static_assert( sizeof( EmotivEvent ) == 84, "EmotivEvent should be 84 bytes" );
+	static_assert( offsetof( EmotivEvent, mWirelessSignalStatus ) == 8, "Unexpected EmotivEvent layout" );
+	static_assert( offsetof( EmotivEvent, mEyebrow ) == 16, "Expressiv flags should pack into one word" );
+	static_assert( offsetof( EmotivEvent, mCognitivAction ) == 56, "Unexpected EmotivEvent layout" );
+	static_assert( offsetof( EmotivEvent, mTheta ) == 80, "Unexpected EmotivEvent layout" );
+};
@@ -0,0 +1,241 @@
+/*
+* 
+* Copyright (c) 2012, Ban the Rewind
+* All rights reserved.
+* 
+* Redistribution and use in source and binary forms, with or 
+* without modification, are permitted provided that the following 
+* conditions are met:
+* 
+* Redistributions of source code must retain the above copyright 
+* notice, this list of conditions and the following disclaimer.
+* Redistributions in binary form must reproduce the above copyright 
+* notice, this list of conditions and the following disclaimer in 
+* the documentation and/or other materials provided with the 
+* distribution.
+* 
+* Neither the name of the Ban the Rewind nor the names of its 
+* contributors may be used to endorse or promote products 
+* derived from this software without specific prior written 
+* permission.
+* 
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS 
+* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT 
+* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS 
+* FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE 
+* COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, 
+* INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+* BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; 
+* LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+* CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, 
+* STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) 
+* ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF 
+* ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+* 
+*/
+
+// Include header
+#include "EmotivFilterBank.h"
+
+// Includes
+#include "cinder/CinderMath.h"
+#include "EmotivKernels.h"
+
+// Imports
+using namespace ci;
+using namespace std;
+
+// Fast enough for neurofeedback, smooth enough for alpha and up
+const float EmotivFilterBank::ENVELOPE_TIME = 0.05f;
+
+// Mean of a rectified sine is 2 / pi of its peak
+static const float ENVELOPE_SCALE = (float)M_PI * 0.5f;
+
+// Quality of the two biquads making up a fourth order Butterworth
+static const double BUTTERWORTH_Q[ 2 ] = { 0.54119610014619698, 1.30656296487637652 };
+
+// Design an RBJ cookbook high or low pass
+static void designPass( float * coefficients, bool highPass, float frequency, float sampleRate, double q )
+{
+	double omega = 2.0 * M_PI * (double)frequency / (double)sampleRate;
+	double cosine = math<double>::cos( omega );
+	double alpha = math<double>::sin( omega ) / ( 2.0 * q );
+	double a0 = 1.0 + alpha;
+	double b1 = highPass ? -( 1.0 + cosine ) : 1.0 - cosine;
+	coefficients[ 0 ] = static_cast<float>( b1 * ( highPass ? -0.5 : 0.5 ) / a0 );
+	coefficients[ 1 ] = static_cast<float>( b1 / a0 );
+	coefficients[ 2 ] = coefficients[ 0 ];
+	coefficients[ 3 ] = static_cast<float>( -2.0 * cosine / a0 );
+	coefficients[ 4 ] = static_cast<float>( ( 1.0 - alpha ) / a0 );
+}
+
+// Create pointer to filter bank
+EmotivFilterBankRef EmotivFilterBank::create( uint32_t capacity )
+{
+	return EmotivFilterBankRef( new EmotivFilterBank( capacity ) );
+}
+
+// Constructor
+EmotivFilterBank::EmotivFilterBank( uint32_t capacity )
+{
+	mDesigned = false;
+	mEnvelopeCoefficient = 0.0f;
+	mEnvelopeTime = ENVELOPE_TIME;
+	mEnvelopeBuffer = EmotivRingBuffer::create( EmotivBandPower::CHANNEL_COUNT * EmotivBandPower::BAND_COUNT, capacity );
+	mFrameCount = 0;
+	mLanes = 0;
+	mNext = 0;
+	mNumChannels = 0;
+	mPrimed = false;
+}
+
+// Compute coefficients and size state
+void EmotivFilterBank::design()
+{
+
+	// Envelope smoothing per sample
+	mEnvelopeCoefficient = static_cast<float>( 1.0 - math<double>::exp( -1.0 / ( (double)max( mEnvelopeTime, 0.001f ) * (double)mSampleRate ) ) );
+
+	// Two high pass stages at the lower edge, and two low pass 
+	// stages at the upper edge if it is clear of Nyquist
+	float nyquist = mSampleRate * 0.5f;
+	for ( int32_t band = 0; band < EmotivBandPower::BAND_COUNT; band++ ) {
+		Band & filters = mBands[ band ];
+		float low = getEmotivBandLow( band );
+		float high = getEmotivBandHigh( band, mSampleRate );
+		filters.mNumStages = 0;
+		if ( low < nyquist ) {
+			designPass( filters.mCoefficients[ filters.mNumStages++ ], true, low, mSampleRate, BUTTERWORTH_Q[ 0 ] );
+			designPass( filters.mCoefficients[ filters.mNumStages++ ], true, low, mSampleRate, BUTTERWORTH_Q[ 1 ] );
+		}
+		if ( high < nyquist * 0.95f ) {
+			designPass( filters.mCoefficients[ filters.mNumStages++ ], false, high, mSampleRate, BUTTERWORTH_Q[ 0 ] );
+			designPass( filters.mCoefficients[ filters.mNumStages++ ], false, high, mSampleRate, BUTTERWORTH_Q[ 1 ] );
+		}
+		filters.mEnvelope.assign( mLanes, 0.0f );
+		filters.mState.assign( MAX_STAGES * 2 * mLanes, 0.0f );
+		filters.mData.resize( MAX_FRAMES * mLanes );
+	}
+	mDesigned = true;
+	mPrimed = false;
+
+}
+
+// Run a band's stages and envelope over the current frames
+void EmotivFilterBank::filter( int32_t band )
+{
+	Band & filters = mBands[ band ];
+	float * data = &filters.mData[ 0 ];
+	memcpy( data, &mFrames[ 0 ], mFrameCount * mLanes * sizeof( float ) );
+	for ( uint32_t stage = 0; stage < filters.mNumStages; stage++ ) {
+		EmotivKernels::biquad( filters.mCoefficients[ stage ], &filters.mState[ stage * 2 * mLanes ], data, mLanes, mFrameCount );
+	}
+	EmotivKernels::envelope( mEnvelopeCoefficient, &filters.mEnvelope[ 0 ], data, mLanes, mFrameCount );
+}
+
+// Filter new samples
+bool EmotivFilterBank::process( const EmotivRingBuffer &buffer, uint32_t windowSize, uint64_t end )
+{
+
+	// Redesign if the shape changes
+	uint32_t numChannels = min<uint32_t>( buffer.getNumChannels(), EmotivBandPower::CHANNEL_COUNT );
+	if ( !mDesigned || numChannels != mNumChannels ) {
+		mNumChannels = numChannels;
+		mLanes = ( ( mNumChannels + EmotivKernels::LANE_WIDTH - 1 ) / EmotivKernels::LANE_WIDTH ) * EmotivKernels::LANE_WIDTH;
+		mFrames.assign( MAX_FRAMES * mLanes, 0.0f );
+		mInput.resize( buffer.getNumChannels() * MAX_FRAMES );
+		mOutput.resize( MAX_FRAMES );
+		design();
+	}
+
+	// Start over after a gap, letting the filters settle on 
+	// the last window
+	uint64_t oldest = end > buffer.getCapacity() ? end - buffer.getCapacity() : 0;
+	if ( !mPrimed || mNext < oldest || mNext > end ) {
+		mNext = max( end > windowSize ? end - windowSize : 0, oldest );
+		for ( int32_t band = 0; band < EmotivBandPower::BAND_COUNT; band++ ) {
+			fill( mBands[ band ].mEnvelope.begin(), mBands[ band ].mEnvelope.end(), 0.0f );
+			fill( mBands[ band ].mState.begin(), mBands[ band ].mState.end(), 0.0f );
+		}
+		mPrimed = true;
+	}
+	if ( mNext >= end ) {
+		return false;
+	}
+
+	// Filter in passes of up to MAX_FRAMES
+	mFftTime = 0.0;
+	mReduceTime = 0.0;
+	while ( mNext < end ) {
+
+		// Interleave channels
+		mFrameCount = static_cast<uint32_t>( min<uint64_t>( end - mNext, MAX_FRAMES ) );
+		if ( buffer.readFrom( &mInput[ 0 ], mNext, mFrameCount ) < mFrameCount ) {
+			mPrimed = false;
+			return false;
+		}
+		for ( uint32_t channel = 0; channel < mNumChannels; channel++ ) {
+			const float * input = &mInput[ channel * mFrameCount ];
+			for ( uint32_t frame = 0; frame < mFrameCount; frame++ ) {
+				mFrames[ frame * mLanes + channel ] = input[ frame ];
+			}
+		}
+
+		// Filter bands, spreading them across the pool if there is one
+		double start = mTimer.getSeconds();
+		if ( mTaskPool ) {
+			EmotivFilterBank * filterBank = this;
+			mTaskPool->run( EmotivBandPower::BAND_COUNT, [ filterBank ]( uint32_t band )
+			{
+				filterBank->filter( static_cast<int32_t>( band ) );
+			} );
+		} else {
+			for ( int32_t band = 0; band < EmotivBandPower::BAND_COUNT; band++ ) {
+				filter( band );
+			}
+		}
+		double filtered = mTimer.getSeconds();
+		mFftTime += filtered - start;
+
+		// Publish envelopes
+		for ( uint32_t channel = 0; channel < mNumChannels; channel++ ) {
+			for ( int32_t band = 0; band < EmotivBandPower::BAND_COUNT; band++ ) {
+				const float * data = &mBands[ band ].mData[ channel ];
+				for ( uint32_t frame = 0; frame < mFrameCount; frame++ ) {
+					mOutput[ frame ] = data[ frame * mLanes ] * ENVELOPE_SCALE;
+				}
+				mEnvelopeBuffer->write( channel * EmotivBandPower::BAND_COUNT + band, &mOutput[ 0 ], mFrameCount );
+			}
+		}
+		mEnvelopeBuffer->commit( mFrameCount );
+		mNext += mFrameCount;
+		mReduceTime += mTimer.getSeconds() - filtered;
+
+	}
+
+	// Band power is the latest envelope
+	for ( uint32_t channel = 0; channel < mNumChannels; channel++ ) {
+		for ( int32_t band = 0; band < EmotivBandPower::BAND_COUNT; band++ ) {
+			setBand( channel, band, mBands[ band ].mEnvelope[ channel ] * ENVELOPE_SCALE );
+		}
+	}
+	averageBands( mNumChannels );
+	return true;
+
+}
+
+// Set envelope time constant
+void EmotivFilterBank::setEnvelopeTime( float seconds )
+{
+	mEnvelopeTime = seconds;
+	mDesigned = false;
+}
+
+// Redesign at the new rate
+void EmotivFilterBank::setSampleRate( float sampleRate )
+{
+	if ( sampleRate != mSampleRate ) {
+		mSampleRate = sampleRate;
+		mDesigned = false;
+	}
+}
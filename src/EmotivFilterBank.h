@@ -0,0 +1,136 @@
+/*
+* 
+* Copyright (c) 2012, Ban the Rewind
+* All rights reserved.
+* 
+* Redistribution and use in source and binary forms, with or 
+* without modification, are permitted provided that the following 
+* conditions are met:
+* 
+* Redistributions of source code must retain the above copyright 
+* notice, this list of conditions and the following disclaimer.
+* Redistributions in binary form must reproduce the above copyright 
+* notice, this list of conditions and the following disclaimer in 
+* the documentation and/or other materials provided with the 
+* distribution.
+* 
+* Neither the name of the Ban the Rewind nor the names of its 
+* contributors may be used to endorse or promote products 
+* derived from this software without specific prior written 
+* permission.
+* 
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS 
+* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT 
+* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS 
+* FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE 
+* COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, 
+* INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+* BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; 
+* LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+* CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, 
+* STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) 
+* ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF 
+* ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+* 
+*/
+
+#pragma once
+
+// Includes
+#include "EmotivAnalyzer.h"
+#include <vector>
+
+// Filter bank pointer alias
+typedef std::shared_ptr<class EmotivFilterBank> EmotivFilterBankRef;
+
+/*
+ * Splits every channel into the five EEG bands with cascaded 
+ * biquads and follows each band's envelope, sample by sample. 
+ * Each band is a fourth order high pass at its lower edge and, 
+ * below Nyquist, a fourth order low pass at its upper edge, each 
+ * a Butterworth made of two biquads. The envelope is a one-pole low pass 
+ * of the rectified band signal, scaled so a sine reads as its 
+ * peak amplitude in microvolts.
+ *
+ * Channels are interleaved so the filter kernels run several of 
+ * them per vector (see EmotivKernels::biquad()). Bands are spread 
+ * across the task pool. Unlike a block FFT there is no window to 
+ * fill, so band amplitude lags the signal only by the filters' 
+ * group delay and the envelope time.
+ */
+class EmotivFilterBank : public EmotivAnalyzer
+{
+
+public:
+
+	// Default envelope time constant in seconds
+	static const float			ENVELOPE_TIME;
+
+	// Create pointer to filter bank. The envelope buffer keeps 
+	// "capacity" samples per band and channel.
+	static EmotivFilterBankRef	create( uint32_t capacity = 2048 );
+
+	// Filters every sample before "end" not seen yet. After a 
+	// gap, the filters start over from the last "windowSize" 
+	// samples to settle. Returns false if there were no new samples.
+	bool						process( const EmotivRingBuffer &buffer, uint32_t windowSize, uint64_t end );
+	bool						isStreaming() const { return true; }
+	void						setSampleRate( float sampleRate );
+
+	// Envelope smoothing. Shorter times follow the signal more 
+	// closely but ripple more in the low bands.
+	float						getEnvelopeTime() const { return mEnvelopeTime; }
+	void						setEnvelopeTime( float seconds );
+
+	// Envelope of every band for every sample. Channel "channel * 
+	// EmotivBandPower::BAND_COUNT + band" holds one band of one EEG 
+	// channel. The buffer can be read from any thread without locking.
+	const EmotivRingBufferRef &	getEnvelopeBuffer() const { return mEnvelopeBuffer; }
+
+private:
+
+	// Constructor
+	EmotivFilterBank( uint32_t capacity );
+
+	// Most biquads per band, and frames filtered per pass
+	static const uint32_t		MAX_FRAMES = 256;
+	static const uint32_t		MAX_STAGES = 4;
+
+	// Filters and state of one band. "mData" is the band's copy 
+	// of the interleaved input, filtered in place.
+	struct Band
+	{
+		float				mCoefficients[ MAX_STAGES ][ 5 ];
+		std::vector<float>	mData;
+		std::vector<float>	mEnvelope;
+		uint32_t			mNumStages;
+		std::vector<float>	mState;
+	};
+
+	// Computes coefficients for the sample rate and clears state
+	void						design();
+
+	// Filters one band of the interleaved frames
+	void						filter( int32_t band );
+
+	// Bands
+	Band						mBands[ EmotivBandPower::BAND_COUNT ];
+	bool						mDesigned;
+	float						mEnvelopeCoefficient;
+	float						mEnvelopeTime;
+
+	// Input. "mFrames" holds "mFrameCount" frames of "mLanes" 
+	// samples, one per channel, padded to the kernel lane width.
+	std::vector<float>			mFrames;
+	uint32_t					mFrameCount;
+	std::vector<float>			mInput;
+	uint32_t					mLanes;
+	uint64_t					mNext;
+	uint32_t					mNumChannels;
+	bool						mPrimed;
+
+	// Output
+	EmotivRingBufferRef			mEnvelopeBuffer;
+	std::vector<float>			mOutput;
+
+};
@@ -0,0 +1,273 @@
+/*
+* 
+* Copyright (c) 2012, Ban the Rewind
+* All rights reserved.
+* 
+* Redistribution and use in source and binary forms, with or 
+* without modification, are permitted provided that the following 
+* conditions are met:
+* 
+* Redistributions of source code must retain the above copyright 
+* notice, this list of conditions and the following disclaimer.
+* Redistributions in binary form must reproduce the above copyright 
+* notice, this list of conditions and the following disclaimer in 
+* the documentation and/or other materials provided with the 
+* distribution.
+* 
+* Neither the name of the Ban the Rewind nor the names of its 
+* contributors may be used to endorse or promote products 
+* derived from this software without specific prior written 
+* permission.
+* 
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS 
+* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT 
+* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS 
+* FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE 
+* COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, 
+* INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+* BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; 
+* LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+* CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, 
+* STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) 
+* ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF 
+* ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+* 
+*/
+
+// Include header
+#include "EmotivGoertzel.h"
+
+// Includes
+#include "cinder/CinderMath.h"
+
+// Imports
+using namespace ci;
+using namespace std;
+
+// Samples between exact recomputations of the DFT state. Sliding 
+// accumulates round-off without bound, so every so often the state 
+// is rebuilt from the window itself.
+static const uint64_t RESYNC_INTERVAL = 4096;
+
+// Create pointer to Goertzel analyzer
+EmotivGoertzelRef EmotivGoertzel::create()
+{
+	return EmotivGoertzelRef( new EmotivGoertzel() );
+}
+
+// Constructor
+EmotivGoertzel::EmotivGoertzel()
+{
+	mEnd = 0;
+	mInputFirst = 0;
+	mInputSize = 0;
+	mNext = 0;
+	mNumChannels = 0;
+	mPrimed = false;
+	mResync = false;
+	mStart = 0;
+	mSynced = 0;
+	mTargetsChanged = true;
+	mWindowSize = 0;
+}
+
+// Add frequency to track
+void EmotivGoertzel::addTarget( float frequency )
+{
+	mFrequencies.push_back( frequency );
+	mTargetsChanged = true;
+}
+
+// Track default frequencies
+void EmotivGoertzel::clearTargets()
+{
+	mFrequencies.clear();
+	mTargetsChanged = true;
+}
+
+// Get amplitude of a target
+float EmotivGoertzel::getAmplitude( uint32_t channel, uint32_t target ) const
+{
+	if ( channel >= mNumChannels || target >= mTargets.size() ) {
+		return 0.0f;
+	}
+	return mAmplitude[ channel * mTargets.size() + target ];
+}
+
+// Take in new samples
+bool EmotivGoertzel::process( const EmotivRingBuffer &buffer, uint32_t windowSize, uint64_t end )
+{
+
+	// Need a window that fits the ring
+	if ( windowSize == 0 || windowSize > buffer.getCapacity() ) {
+		return false;
+	}
+
+	// Start over if the shape or targets change
+	uint32_t numChannels = min<uint32_t>( buffer.getNumChannels(), EmotivBandPower::CHANNEL_COUNT );
+	if ( mTargetsChanged || windowSize != mWindowSize || numChannels != mNumChannels ) {
+		reset( numChannels, windowSize );
+	}
+
+	// Start over too if samples leaving the window have been 
+	// overwritten or the buffer went backwards. The new window 
+	// starts with the latest "windowSize" samples.
+	uint64_t oldest = end > buffer.getCapacity() ? end - buffer.getCapacity() : 0;
+	uint64_t first = mNext > mWindowSize ? max( mNext - mWindowSize, mStart ) : mStart;
+	if ( !mPrimed || first < oldest || mNext > end ) {
+		mStart = max( end > mWindowSize ? end - mWindowSize : 0, oldest );
+		mNext = mStart;
+		mSynced = mStart;
+		first = mStart;
+		fill( mState.begin(), mState.end(), 0.0 );
+		mPrimed = true;
+	}
+	if ( mNext >= end ) {
+		return false;
+	}
+
+	// Copy samples from the oldest one leaving the window to the newest
+	mInputFirst = first;
+	mInputSize = static_cast<uint32_t>( end - first );
+	if ( mInput.size() < buffer.getNumChannels() * mInputSize ) {
+		mInput.resize( buffer.getNumChannels() * mInputSize );
+	}
+	if ( buffer.readFrom( &mInput[ 0 ], mInputFirst, mInputSize ) < mInputSize ) {
+		mPrimed = false;
+		return false;
+	}
+	mEnd = end;
+	mResync = end - mSynced >= RESYNC_INTERVAL;
+	if ( mResync ) {
+		mSynced = end;
+	}
+
+	// Update channels, spreading them across the pool if there is one
+	double start = mTimer.getSeconds();
+	if ( mTaskPool ) {
+		EmotivGoertzel * goertzel = this;
+		mTaskPool->run( mNumChannels, [ goertzel ]( uint32_t channel )
+		{
+			goertzel->update( channel );
+		} );
+	} else {
+		for ( uint32_t channel = 0; channel < mNumChannels; channel++ ) {
+			update( channel );
+		}
+	}
+	mNext = end;
+	double updated = mTimer.getSeconds();
+	mFftTime = updated - start;
+
+	// Average targets into bands
+	size_t numTargets = mTargets.size();
+	for ( uint32_t channel = 0; channel < mNumChannels; channel++ ) {
+		const float * amplitude = &mAmplitude[ channel * numTargets ];
+		float sums[ EmotivBandPower::BAND_COUNT ] = { 0.0f };
+		uint32_t counts[ EmotivBandPower::BAND_COUNT ] = { 0 };
+		for ( size_t target = 0; target < numTargets; target++ ) {
+			int32_t band = mTargets[ target ].mBand;
+			if ( band >= 0 ) {
+				sums[ band ] += amplitude[ target ];
+				counts[ band ]++;
+			}
+		}
+		for ( int32_t band = 0; band < EmotivBandPower::BAND_COUNT; band++ ) {
+			setBand( channel, band, counts[ band ] > 0 ? sums[ band ] / (float)counts[ band ] : 0.0f );
+		}
+	}
+	averageBands( mNumChannels );
+	mReduceTime = mTimer.getSeconds() - updated;
+
+	return true;
+
+}
+
+// Rebuild targets for a window size
+void EmotivGoertzel::reset( uint32_t numChannels, uint32_t windowSize )
+{
+
+	// Use whole frequencies up to Nyquist if none are set
+	vector<float> frequencies = mFrequencies;
+	if ( frequencies.empty() ) {
+		for ( uint32_t frequency = 1; (float)frequency < mSampleRate * 0.5f; frequency++ ) {
+			frequencies.push_back( (float)frequency );
+		}
+	}
+
+	// The DFT over the last N samples, referenced to the newest, 
+	// is X( n ) = x( n ) + e^jw X( n - 1 ) - e^jwN x( n - N )
+	mTargets.clear();
+	for ( vector<float>::const_iterator frequencyIt = frequencies.begin(); frequencyIt != frequencies.end(); ++frequencyIt ) {
+		double omega = 2.0 * M_PI * (double)*frequencyIt / (double)mSampleRate;
+		Target target;
+		target.mBand = getEmotivBand( *frequencyIt );
+		target.mFrequency = *frequencyIt;
+		target.mRemoveIm = math<double>::sin( omega * (double)windowSize );
+		target.mRemoveRe = math<double>::cos( omega * (double)windowSize );
+		target.mRotateIm = math<double>::sin( omega );
+		target.mRotateRe = math<double>::cos( omega );
+		mTargets.push_back( target );
+	}
+
+	// Clear state
+	mNumChannels = numChannels;
+	mWindowSize = windowSize;
+	mAmplitude.assign( mNumChannels * mTargets.size(), 0.0f );
+	mState.assign( mNumChannels * mTargets.size() * 2, 0.0 );
+	mPrimed = false;
+	mTargetsChanged = false;
+
+}
+
+// Rebuild targets at the new rate
+void EmotivGoertzel::setSampleRate( float sampleRate )
+{
+	if ( sampleRate != mSampleRate ) {
+		mSampleRate = sampleRate;
+		mTargetsChanged = true;
+	}
+}
+
+// Slide every target of a channel over the new samples
+void EmotivGoertzel::update( uint32_t channel )
+{
+	size_t numTargets = mTargets.size();
+	const float * input = &mInput[ channel * mInputSize ];
+	double * state = &mState[ channel * numTargets * 2 ];
+
+	// Rebuild the DFT by running the window in from zero with 
+	// nothing to remove. The copied samples always cover it.
+	if ( mResync ) {
+		fill( state, state + numTargets * 2, 0.0 );
+		for ( uint64_t sample = max( mEnd > mWindowSize ? mEnd - mWindowSize : 0, mStart ); sample < mEnd; sample++ ) {
+			double value = input[ sample - mInputFirst ];
+			for ( size_t target = 0; target < numTargets; target++ ) {
+				const Target & t = mTargets[ target ];
+				double re = state[ target * 2 ];
+				double im = state[ target * 2 + 1 ];
+				state[ target * 2 ] = value + t.mRotateRe * re - t.mRotateIm * im;
+				state[ target * 2 + 1 ] = t.mRotateRe * im + t.mRotateIm * re;
+			}
+		}
+	}
+
+	// Slide
+	for ( uint64_t sample = mResync ? mEnd : mNext; sample < mEnd; sample++ ) {
+		double value = input[ sample - mInputFirst ];
+		double removed = sample >= mStart + mWindowSize ? input[ sample - mWindowSize - mInputFirst ] : 0.0;
+		for ( size_t target = 0; target < numTargets; target++ ) {
+			const Target & t = mTargets[ target ];
+			double re = state[ target * 2 ];
+			double im = state[ target * 2 + 1 ];
+			state[ target * 2 ] = value + t.mRotateRe * re - t.mRotateIm * im - removed * t.mRemoveRe;
+			state[ target * 2 + 1 ] = t.mRotateRe * im + t.mRotateIm * re - removed * t.mRemoveIm;
+		}
+	}
+	float * amplitude = &mAmplitude[ channel * numTargets ];
+	for ( size_t target = 0; target < numTargets; target++ ) {
+		double re = state[ target * 2 ];
+		double im = state[ target * 2 + 1 ];
+		amplitude[ target ] = static_cast<float>( math<double>::sqrt( re * re + im * im ) );
+	}
+}
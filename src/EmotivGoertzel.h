@@ -0,0 +1,139 @@
+/*
+* 
+* Copyright (c) 2012, Ban the Rewind
+* All rights reserved.
+* 
+* Redistribution and use in source and binary forms, with or 
+* without modification, are permitted provided that the following 
+* conditions are met:
+* 
+* Redistributions of source code must retain the above copyright 
+* notice, this list of conditions and the following disclaimer.
+* Redistributions in binary form must reproduce the above copyright 
+* notice, this list of conditions and the following disclaimer in 
+* the documentation and/or other materials provided with the 
+* distribution.
+* 
+* Neither the name of the Ban the Rewind nor the names of its 
+* contributors may be used to endorse or promote products 
+* derived from this software without specific prior written 
+* permission.
+* 
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS 
+* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT 
+* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS 
+* FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE 
+* COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, 
+* INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+* BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; 
+* LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+* CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, 
+* STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) 
+* ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF 
+* ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+* 
+*/
+
+#pragma once
+
+// Includes
+#include "EmotivAnalyzer.h"
+#include <vector>
+
+// Goertzel pointer alias
+typedef std::shared_ptr<class EmotivGoertzel> EmotivGoertzelRef;
+
+/*
+ * Tracks a few frequencies per channel with a sliding DFT, the 
+ * streaming form of the Goertzel algorithm. Each target's DFT 
+ * over the last "windowSize" samples is updated in O(1) per 
+ * sample by adding the newest sample and removing the one that 
+ * leaves the window, which is read back from the ring buffer. 
+ * The state is rebuilt from the window every few thousand 
+ * samples so round-off can't build up over long sessions. This 
+ * suits SSVEP stimulus frequencies or a single band, where a full 
+ * FFT would compute bins nobody reads.
+ *
+ * Target amplitudes are on the same scale as FFT bins of the same 
+ * window size. Each band reports the mean amplitude of the targets 
+ * that fall in it and reads zero if there are none.
+ */
+class EmotivGoertzel : public EmotivAnalyzer
+{
+
+public:
+
+	// Create pointer to Goertzel analyzer
+	static EmotivGoertzelRef	create();
+
+	// Updates each channel with every sample before "end" it has 
+	// not seen yet. Starts over if the window size changes or 
+	// samples it needs have been overwritten. Returns false if 
+	// there were no new samples.
+	bool						process( const EmotivRingBuffer &buffer, uint32_t windowSize, uint64_t end );
+	bool						isStreaming() const { return true; }
+	void						setSampleRate( float sampleRate );
+
+	// Frequencies to track, in Hz. Until targets are added, every 
+	// whole frequency from 1Hz up to Nyquist is tracked, which 
+	// approximates the FFT.
+	void						addTarget( float frequency );
+	void						clearTargets();
+	const std::vector<float> &	getTargets() const { return mFrequencies; }
+
+	// Amplitude of the "target"th tracked frequency on a channel
+	float						getAmplitude( uint32_t channel, uint32_t target ) const;
+	uint32_t					getNumTargets() const { return static_cast<uint32_t>( mTargets.size() ); }
+
+private:
+
+	// Constructor
+	EmotivGoertzel();
+
+	// Tracked frequency. "mRotate" turns the DFT one sample 
+	// forward, "mRemove" is the weight of the sample leaving 
+	// the window.
+	struct Target
+	{
+		int32_t	mBand;
+		float	mFrequency;
+		double	mRemoveIm;
+		double	mRemoveRe;
+		double	mRotateIm;
+		double	mRotateRe;
+	};
+
+	// Rebuilds targets and clears state for a new window size
+	void						reset( uint32_t numChannels, uint32_t windowSize );
+
+	// Runs one channel over the copied samples
+	void						update( uint32_t channel );
+
+	// Targets
+	std::vector<float>			mFrequencies;
+	bool						mTargetsChanged;
+	std::vector<Target>			mTargets;
+
+	// DFT state, real and imaginary per target per channel, and 
+	// the amplitudes derived from it
+	std::vector<float>			mAmplitude;
+	std::vector<double>			mState;
+
+	// Samples [ mInputFirst, mEnd ) copied out of the ring. The 
+	// window restarted at mStart; samples before it count as zero.
+	std::vector<float>			mInput;
+	uint64_t					mInputFirst;
+	uint32_t					mInputSize;
+	uint64_t					mNext;
+	uint64_t					mEnd;
+	uint32_t					mNumChannels;
+	bool						mPrimed;
+	uint64_t					mStart;
+	uint32_t					mWindowSize;
+
+	// Set when this update rebuilds the state instead of sliding. 
+	// mSynced is the end of the last rebuild.
+	bool						mResync;
+	uint64_t					mSynced;
+
+};
@@ -0,0 +1,498 @@
+/*
+* 
+* Copyright (c) 2012, Ban the Rewind
+* All rights reserved.
+* 
+* Redistribution and use in source and binary forms, with or 
+* without modification, are permitted provided that the following 
+* conditions are met:
+* 
+* Redistributions of source code must retain the above copyright 
+* notice, this list of conditions and the following disclaimer.
+* Redistributions in binary form must reproduce the above copyright 
+* notice, this list of conditions and the following disclaimer in 
+* the documentation and/or other materials provided with the 
+* distribution.
+* 
+* Neither the name of the Ban the Rewind nor the names of its 
+* contributors may be used to endorse or promote products 
+* derived from this software without specific prior written 
+* permission.
+* 
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS 
+* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT 
+* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS 
+* FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE 
+* COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, 
+* INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+* BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; 
+* LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+* CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, 
+* STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) 
+* ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF 
+* ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+* 
+*/
+
+// Include header
+#include "EmotivKernels.h"
+
+// Includes
+#include <cmath>
+#include <cstring>
+
+// Vector instruction sets available to the compiler. Visual 
+// Studio accepts SSE2 intrinsics on any x86 target, even without 
+// /arch:SSE2, so 32-bit builds get the SSE2 kernels too. They 
+// only run after CPUID reports SSE2. AVX2 intrinsics need Visual 
+// Studio 2013 or a GCC-style compiler that can target it per 
+// function.
+#if ( defined( _MSC_VER ) && ( defined( _M_IX86 ) || defined( _M_X64 ) ) ) || defined( __SSE2__ )
+#define EMOTIV_SSE2
+#include <emmintrin.h>
+#endif
+#if defined( EMOTIV_SSE2 ) && ( ( defined( _MSC_VER ) && _MSC_VER >= 1800 ) || defined( __GNUC__ ) )
+#define EMOTIV_AVX2
+#include <immintrin.h>
+#endif
+
+// CPU feature detection
+#if defined( _MSC_VER )
+#include <intrin.h>
+#elif defined( EMOTIV_SSE2 )
+#include <cpuid.h>
+#endif
+
+// Functions using AVX2 are compiled for it individually so 
+// the rest of the library keeps the baseline instruction set
+#if defined( EMOTIV_AVX2 ) && defined( __GNUC__ )
+#define EMOTIV_TARGET_AVX2 __attribute__( ( target( "avx2,fma" ) ) )
+#else
+#define EMOTIV_TARGET_AVX2
+#endif
+
+// Imports
+using namespace std;
+
+// Kernel set
+struct KernelTable
+{
+	void	( *mBiquad )( const float *, float *, float *, uint32_t, uint32_t );
+	void	( *mConvert )( const double *, float *, uint32_t );
+	void	( *mEnvelope )( float, float *, float *, uint32_t, uint32_t );
+	void	( *mMultiply )( const float *, const float *, float *, uint32_t );
+	void	( *mPower )( const float *, const float *, float *, uint32_t );
+	float	( *mSum )( const float *, uint32_t );
+};
+
+// Scalar kernels
+
+static void biquadScalar( const float * coefficients, float * state, float * data, uint32_t lanes, uint32_t frames )
+{
+	float b0 = coefficients[ 0 ], b1 = coefficients[ 1 ], b2 = coefficients[ 2 ], a1 = coefficients[ 3 ], a2 = coefficients[ 4 ];
+	for ( uint32_t lane = 0; lane < lanes; lane++ ) {
+		float z1 = state[ lane ];
+		float z2 = state[ lanes + lane ];
+		for ( uint32_t frame = 0; frame < frames; frame++ ) {
+			float & sample = data[ frame * lanes + lane ];
+			float x = sample;
+			float y = b0 * x + z1;
+			z1 = b1 * x - a1 * y + z2;
+			z2 = b2 * x - a2 * y;
+			sample = y;
+		}
+		state[ lane ] = z1;
+		state[ lanes + lane ] = z2;
+	}
+}
+
+static void envelopeScalar( float coefficient, float * state, float * data, uint32_t lanes, uint32_t frames )
+{
+	for ( uint32_t lane = 0; lane < lanes; lane++ ) {
+		float value = state[ lane ];
+		for ( uint32_t frame = 0; frame < frames; frame++ ) {
+			float & sample = data[ frame * lanes + lane ];
+			value += coefficient * ( fabsf( sample ) - value );
+			sample = value;
+		}
+		state[ lane ] = value;
+	}
+}
+
+static void convertScalar( const double * src, float * dest, uint32_t count )
+{
+	for ( uint32_t i = 0; i < count; i++ ) {
+		dest[ i ] = static_cast<float>( src[ i ] );
+	}
+}
+
+static void multiplyScalar( const float * src, const float * window, float * dest, uint32_t count )
+{
+	for ( uint32_t i = 0; i < count; i++ ) {
+		dest[ i ] = src[ i ] * window[ i ];
+	}
+}
+
+static void powerScalar( const float * real, const float * imaginary, float * dest, uint32_t count )
+{
+	for ( uint32_t i = 0; i < count; i++ ) {
+		dest[ i ] = real[ i ] * real[ i ] + imaginary[ i ] * imaginary[ i ];
+	}
+}
+
+static float sumScalar( const float * src, uint32_t count )
+{
+	float sum = 0.0f;
+	for ( uint32_t i = 0; i < count; i++ ) {
+		sum += src[ i ];
+	}
+	return sum;
+}
+
+// SSE2 kernels. Four floats per step, leftovers are 
+// handled by the scalar versions.
+#ifdef EMOTIV_SSE2
+
+static void biquadSse2( const float * coefficients, float * state, float * data, uint32_t lanes, uint32_t frames )
+{
+	__m128 b0 = _mm_set1_ps( coefficients[ 0 ] );
+	__m128 b1 = _mm_set1_ps( coefficients[ 1 ] );
+	__m128 b2 = _mm_set1_ps( coefficients[ 2 ] );
+	__m128 a1 = _mm_set1_ps( coefficients[ 3 ] );
+	__m128 a2 = _mm_set1_ps( coefficients[ 4 ] );
+	for ( uint32_t lane = 0; lane < lanes; lane += 4 ) {
+		__m128 z1 = _mm_loadu_ps( state + lane );
+		__m128 z2 = _mm_loadu_ps( state + lanes + lane );
+		for ( uint32_t frame = 0; frame < frames; frame++ ) {
+			float * sample = data + frame * lanes + lane;
+			__m128 x = _mm_loadu_ps( sample );
+			__m128 y = _mm_add_ps( _mm_mul_ps( b0, x ), z1 );
+			z1 = _mm_add_ps( _mm_sub_ps( _mm_mul_ps( b1, x ), _mm_mul_ps( a1, y ) ), z2 );
+			z2 = _mm_sub_ps( _mm_mul_ps( b2, x ), _mm_mul_ps( a2, y ) );
+			_mm_storeu_ps( sample, y );
+		}
+		_mm_storeu_ps( state + lane, z1 );
+		_mm_storeu_ps( state + lanes + lane, z2 );
+	}
+}
+
+static void envelopeSse2( float coefficient, float * state, float * data, uint32_t lanes, uint32_t frames )
+{
+	__m128 k = _mm_set1_ps( coefficient );
+	__m128 sign = _mm_set1_ps( -0.0f );
+	for ( uint32_t lane = 0; lane < lanes; lane += 4 ) {
+		__m128 value = _mm_loadu_ps( state + lane );
+		for ( uint32_t frame = 0; frame < frames; frame++ ) {
+			float * sample = data + frame * lanes + lane;
+			__m128 rectified = _mm_andnot_ps( sign, _mm_loadu_ps( sample ) );
+			value = _mm_add_ps( value, _mm_mul_ps( k, _mm_sub_ps( rectified, value ) ) );
+			_mm_storeu_ps( sample, value );
+		}
+		_mm_storeu_ps( state + lane, value );
+	}
+}
+
+static void convertSse2( const double * src, float * dest, uint32_t count )
+{
+	uint32_t i = 0;
+	for ( ; i + 4 <= count; i += 4 ) {
+		__m128 low = _mm_cvtpd_ps( _mm_loadu_pd( src + i ) );
+		__m128 high = _mm_cvtpd_ps( _mm_loadu_pd( src + i + 2 ) );
+		_mm_storeu_ps( dest + i, _mm_movelh_ps( low, high ) );
+	}
+	convertScalar( src + i, dest + i, count - i );
+}
+
+static void multiplySse2( const float * src, const float * window, float * dest, uint32_t count )
+{
+	uint32_t i = 0;
+	for ( ; i + 4 <= count; i += 4 ) {
+		_mm_storeu_ps( dest + i, _mm_mul_ps( _mm_loadu_ps( src + i ), _mm_loadu_ps( window + i ) ) );
+	}
+	multiplyScalar( src + i, window + i, dest + i, count - i );
+}
+
+static void powerSse2( const float * real, const float * imaginary, float * dest, uint32_t count )
+{
+	uint32_t i = 0;
+	for ( ; i + 4 <= count; i += 4 ) {
+		__m128 re = _mm_loadu_ps( real + i );
+		__m128 im = _mm_loadu_ps( imaginary + i );
+		_mm_storeu_ps( dest + i, _mm_add_ps( _mm_mul_ps( re, re ), _mm_mul_ps( im, im ) ) );
+	}
+	powerScalar( real + i, imaginary + i, dest + i, count - i );
+}
+
+static float sumSse2( const float * src, uint32_t count )
+{
+	__m128 total = _mm_setzero_ps();
+	uint32_t i = 0;
+	for ( ; i + 4 <= count; i += 4 ) {
+		total = _mm_add_ps( total, _mm_loadu_ps( src + i ) );
+	}
+	float lanes[ 4 ];
+	_mm_storeu_ps( lanes, total );
+	return ( lanes[ 0 ] + lanes[ 1 ] ) + ( lanes[ 2 ] + lanes[ 3 ] ) + sumScalar( src + i, count - i );
+}
+
+#endif
+
+// AVX2 kernels. Eight floats per step.
+#ifdef EMOTIV_AVX2
+
+EMOTIV_TARGET_AVX2 static void biquadAvx2( const float * coefficients, float * state, float * data, uint32_t lanes, uint32_t frames )
+{
+	__m256 b0 = _mm256_set1_ps( coefficients[ 0 ] );
+	__m256 b1 = _mm256_set1_ps( coefficients[ 1 ] );
+	__m256 b2 = _mm256_set1_ps( coefficients[ 2 ] );
+	__m256 a1 = _mm256_set1_ps( coefficients[ 3 ] );
+	__m256 a2 = _mm256_set1_ps( coefficients[ 4 ] );
+	uint32_t lane = 0;
+	for ( ; lane + 8 <= lanes; lane += 8 ) {
+		__m256 z1 = _mm256_loadu_ps( state + lane );
+		__m256 z2 = _mm256_loadu_ps( state + lanes + lane );
+		for ( uint32_t frame = 0; frame < frames; frame++ ) {
+			float * sample = data + frame * lanes + lane;
+			__m256 x = _mm256_loadu_ps( sample );
+			__m256 y = _mm256_fmadd_ps( b0, x, z1 );
+			z1 = _mm256_add_ps( _mm256_fnmadd_ps( a1, y, _mm256_mul_ps( b1, x ) ), z2 );
+			z2 = _mm256_fnmadd_ps( a2, y, _mm256_mul_ps( b2, x ) );
+			_mm256_storeu_ps( sample, y );
+		}
+		_mm256_storeu_ps( state + lane, z1 );
+		_mm256_storeu_ps( state + lanes + lane, z2 );
+	}
+
+	// A leftover group of four goes through SSE2
+	if ( lane < lanes ) {
+		float tail[ 8 ] = { state[ lane ], state[ lane + 1 ], state[ lane + 2 ], state[ lane + 3 ], 
+			state[ lanes + lane ], state[ lanes + lane + 1 ], state[ lanes + lane + 2 ], state[ lanes + lane + 3 ] };
+		for ( uint32_t frame = 0; frame < frames; frame++ ) {
+			biquadSse2( coefficients, tail, data + frame * lanes + lane, 4, 1 );
+		}
+		memcpy( state + lane, tail, 4 * sizeof( float ) );
+		memcpy( state + lanes + lane, tail + 4, 4 * sizeof( float ) );
+	}
+}
+
+EMOTIV_TARGET_AVX2 static void envelopeAvx2( float coefficient, float * state, float * data, uint32_t lanes, uint32_t frames )
+{
+	__m256 k = _mm256_set1_ps( coefficient );
+	__m256 sign = _mm256_set1_ps( -0.0f );
+	uint32_t lane = 0;
+	for ( ; lane + 8 <= lanes; lane += 8 ) {
+		__m256 value = _mm256_loadu_ps( state + lane );
+		for ( uint32_t frame = 0; frame < frames; frame++ ) {
+			float * sample = data + frame * lanes + lane;
+			__m256 rectified = _mm256_andnot_ps( sign, _mm256_loadu_ps( sample ) );
+			value = _mm256_fmadd_ps( k, _mm256_sub_ps( rectified, value ), value );
+			_mm256_storeu_ps( sample, value );
+		}
+		_mm256_storeu_ps( state + lane, value );
+	}
+	for ( ; lane < lanes; lane += 4 ) {
+		float tail[ 4 ] = { state[ lane ], state[ lane + 1 ], state[ lane + 2 ], state[ lane + 3 ] };
+		for ( uint32_t frame = 0; frame < frames; frame++ ) {
+			envelopeSse2( coefficient, tail, data + frame * lanes + lane, 4, 1 );
+		}
+		memcpy( state + lane, tail, 4 * sizeof( float ) );
+	}
+}
+
+EMOTIV_TARGET_AVX2 static void convertAvx2( const double * src, float * dest, uint32_t count )
+{
+	uint32_t i = 0;
+	for ( ; i + 8 <= count; i += 8 ) {
+		__m128 low = _mm256_cvtpd_ps( _mm256_loadu_pd( src + i ) );
+		__m128 high = _mm256_cvtpd_ps( _mm256_loadu_pd( src + i + 4 ) );
+		_mm256_storeu_ps( dest + i, _mm256_insertf128_ps( _mm256_castps128_ps256( low ), high, 1 ) );
+	}
+	convertScalar( src + i, dest + i, count - i );
+}
+
+EMOTIV_TARGET_AVX2 static void multiplyAvx2( const float * src, const float * window, float * dest, uint32_t count )
+{
+	uint32_t i = 0;
+	for ( ; i + 8 <= count; i += 8 ) {
+		_mm256_storeu_ps( dest + i, _mm256_mul_ps( _mm256_loadu_ps( src + i ), _mm256_loadu_ps( window + i ) ) );
+	}
+	multiplyScalar( src + i, window + i, dest + i, count - i );
+}
+
+EMOTIV_TARGET_AVX2 static void powerAvx2( const float * real, const float * imaginary, float * dest, uint32_t count )
+{
+	uint32_t i = 0;
+	for ( ; i + 8 <= count; i += 8 ) {
+		__m256 re = _mm256_loadu_ps( real + i );
+		__m256 im = _mm256_loadu_ps( imaginary + i );
+		_mm256_storeu_ps( dest + i, _mm256_fmadd_ps( re, re, _mm256_mul_ps( im, im ) ) );
+	}
+	powerScalar( real + i, imaginary + i, dest + i, count - i );
+}
+
+EMOTIV_TARGET_AVX2 static float sumAvx2( const float * src, uint32_t count )
+{
+	__m256 total = _mm256_setzero_ps();
+	uint32_t i = 0;
+	for ( ; i + 8 <= count; i += 8 ) {
+		total = _mm256_add_ps( total, _mm256_loadu_ps( src + i ) );
+	}
+	__m128 half = _mm_add_ps( _mm256_castps256_ps128( total ), _mm256_extractf128_ps( total, 1 ) );
+	float lanes[ 4 ];
+	_mm_storeu_ps( lanes, half );
+	return ( lanes[ 0 ] + lanes[ 1 ] ) + ( lanes[ 2 ] + lanes[ 3 ] ) + sumScalar( src + i, count - i );
+}
+
+#endif
+
+// Read CPUID leaf "leaf", sub-leaf 0, into EAX, EBX, ECX, EDX
+#ifdef EMOTIV_SSE2
+static void cpuid( int32_t leaf, int32_t registers[ 4 ] )
+{
+#if defined( _MSC_VER )
+	__cpuidex( registers, leaf, 0 );
+#else
+	uint32_t eax = 0, ebx = 0, ecx = 0, edx = 0;
+	__cpuid_count( leaf, 0, eax, ebx, ecx, edx );
+	registers[ 0 ] = eax;
+	registers[ 1 ] = ebx;
+	registers[ 2 ] = ecx;
+	registers[ 3 ] = edx;
+#endif
+}
+#endif
+
+// Find the best instruction set both the compiler and CPU support
+static int32_t detectIsa()
+{
+	int32_t isa = EmotivKernels::ISA_SCALAR;
+#ifdef EMOTIV_SSE2
+	int32_t registers[ 4 ] = { 0, 0, 0, 0 };
+	cpuid( 1, registers );
+	if ( ( registers[ 3 ] & ( 1 << 26 ) ) == 0 ) {
+		return isa;
+	}
+	isa = EmotivKernels::ISA_SSE2;
+#ifdef EMOTIV_AVX2
+
+	// AVX2 needs FMA, plus the OS saving YMM registers (OSXSAVE 
+	// set and XCR0 bits 1 and 2)
+	bool fma = ( registers[ 2 ] & ( 1 << 12 ) ) != 0;
+	bool osxsave = ( registers[ 2 ] & ( 1 << 27 ) ) != 0;
+	if ( !fma || !osxsave ) {
+		return isa;
+	}
+#if defined( _MSC_VER )
+	uint64_t xcr0 = _xgetbv( 0 );
+#else
+	uint32_t xcr0Low = 0, xcr0High = 0;
+	__asm__ __volatile__ ( "xgetbv" : "=a"( xcr0Low ), "=d"( xcr0High ) : "c"( 0 ) );
+	uint64_t xcr0 = ( (uint64_t)xcr0High << 32 ) | xcr0Low;
+#endif
+	if ( ( xcr0 & 0x6 ) != 0x6 ) {
+		return isa;
+	}
+	cpuid( 0, registers );
+	if ( registers[ 0 ] < 7 ) {
+		return isa;
+	}
+	cpuid( 7, registers );
+	if ( ( registers[ 1 ] & ( 1 << 5 ) ) != 0 ) {
+		isa = EmotivKernels::ISA_AVX2;
+	}
+
+#endif
+#endif
+	return isa;
+}
+
+// Build kernel set for an instruction set
+static KernelTable getKernelTable( int32_t isa )
+{
+	KernelTable table = { &biquadScalar, &convertScalar, &envelopeScalar, &multiplyScalar, &powerScalar, &sumScalar };
+#ifdef EMOTIV_SSE2
+	if ( isa == EmotivKernels::ISA_SSE2 ) {
+		KernelTable sse2 = { &biquadSse2, &convertSse2, &envelopeSse2, &multiplySse2, &powerSse2, &sumSse2 };
+		table = sse2;
+	}
+#endif
+#ifdef EMOTIV_AVX2
+	if ( isa == EmotivKernels::ISA_AVX2 ) {
+		KernelTable avx2 = { &biquadAvx2, &convertAvx2, &envelopeAvx2, &multiplyAvx2, &powerAvx2, &sumAvx2 };
+		table = avx2;
+	}
+#endif
+	return table;
+}
+
+// Selected when the library loads
+static const int32_t	sSupportedIsa	= detectIsa();
+static int32_t			sIsa			= sSupportedIsa;
+static KernelTable		sKernels		= getKernelTable( sSupportedIsa );
+
+// Filter interleaved lanes
+void EmotivKernels::biquad( const float * coefficients, float * state, float * data, uint32_t lanes, uint32_t frames )
+{
+	sKernels.mBiquad( coefficients, state, data, lanes, frames );
+}
+
+// Convert doubles to floats
+void EmotivKernels::convert( const double * src, float * dest, uint32_t count )
+{
+	sKernels.mConvert( src, dest, count );
+}
+
+// Follow envelopes of interleaved lanes
+void EmotivKernels::envelope( float coefficient, float * state, float * data, uint32_t lanes, uint32_t frames )
+{
+	sKernels.mEnvelope( coefficient, state, data, lanes, frames );
+}
+
+// Get instruction set in use
+int32_t EmotivKernels::getIsa()
+{
+	return sIsa;
+}
+
+// Get instruction set name
+const char * EmotivKernels::getIsaName( int32_t isa )
+{
+	switch ( isa ) {
+	case ISA_SSE2:
+		return "SSE2";
+	case ISA_AVX2:
+		return "AVX2";
+	}
+	return "Scalar";
+}
+
+// Get best available instruction set
+int32_t EmotivKernels::getSupportedIsa()
+{
+	return sSupportedIsa;
+}
+
+// Multiply by window
+void EmotivKernels::multiply( const float * src, const float * window, float * dest, uint32_t count )
+{
+	sKernels.mMultiply( src, window, dest, count );
+}
+
+// Squared magnitudes
+void EmotivKernels::power( const float * real, const float * imaginary, float * dest, uint32_t count )
+{
+	sKernels.mPower( real, imaginary, dest, count );
+}
+
+// Select instruction set
+void EmotivKernels::setIsa( int32_t isa )
+{
+	sIsa = max( min( isa, sSupportedIsa ), static_cast<int32_t>( ISA_SCALAR ) );
+	sKernels = getKernelTable( sIsa );
+}
+
+// Sum values
+float EmotivKernels::sum( const float * src, uint32_t count )
+{
+	return sKernels.mSum( src, count );
+}
@@ -0,0 +1,94 @@
+/*
+* 
+* Copyright (c) 2012, Ban the Rewind
+* All rights reserved.
+* 
+* Redistribution and use in source and binary forms, with or 
+* without modification, are permitted provided that the following 
+* conditions are met:
+* 
+* Redistributions of source code must retain the above copyright 
+* notice, this list of conditions and the following disclaimer.
+* Redistributions in binary form must reproduce the above copyright 
+* notice, this list of conditions and the following disclaimer in 
+* the documentation and/or other materials provided with the 
+* distribution.
+* 
+* Neither the name of the Ban the Rewind nor the names of its 
+* contributors may be used to endorse or promote products 
+* derived from this software without specific prior written 
+* permission.
+* 
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS 
+* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT 
+* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS 
+* FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE 
+* COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, 
+* INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+* BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; 
+* LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+* CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, 
+* STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) 
+* ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF 
+* ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+* 
+*/
+
+#pragma once
+
+// Includes
+#include "cinder/Cinder.h"
+
+/*
+ * Vector kernels for the acquisition and analysis path. Each 
+ * kernel has a scalar, an SSE2 and an AVX2 version. The fastest 
+ * one the CPU and compiler support is picked when the library 
+ * loads. Pointers need no particular alignment.
+ */
+class EmotivKernels
+{
+
+public:
+
+	// Instruction sets
+	static const int32_t ISA_SCALAR	= 0;
+	static const int32_t ISA_SSE2	= 1;
+	static const int32_t ISA_AVX2	= 2;
+
+	// Instruction set in use, and the best one available. Use 
+	// setIsa() to compare versions. Requests above the best 
+	// available set fall back to it. Not thread-safe; call 
+	// before any analysis starts.
+	static int32_t		getIsa();
+	static int32_t		getSupportedIsa();
+	static void			setIsa( int32_t isa );
+	static const char *	getIsaName( int32_t isa );
+
+	// Filters interleaved signals in place, one frame of "lanes" 
+	// samples at a time. "lanes" must be a multiple of LANE_WIDTH. 
+	// "coefficients" are b0, b1, b2, a1, a2, normalized so a0 is 
+	// one. "state" holds two values per lane (transposed direct 
+	// form II), first all z1 then all z2.
+	static const uint32_t LANE_WIDTH = 4;
+	static void			biquad( const float * coefficients, float * state, float * data, uint32_t lanes, uint32_t frames );
+
+	// Replaces interleaved samples with their envelope, a one-pole 
+	// low pass of the rectified signal: e += coefficient * ( |x| - e ). 
+	// Same layout as biquad(), with one value of state per lane.
+	static void			envelope( float coefficient, float * state, float * data, uint32_t lanes, uint32_t frames );
+
+	// Converts raw EDK samples from double to float
+	static void			convert( const double * src, float * dest, uint32_t count );
+
+	// Multiplies samples by a window, element by element. "src" 
+	// and "dest" may be the same.
+	static void			multiply( const float * src, const float * window, float * dest, uint32_t count );
+
+	// Squared magnitude of complex bins given as separate real 
+	// and imaginary parts
+	static void			power( const float * real, const float * imaginary, float * dest, uint32_t count );
+
+	// Sums "count" values
+	static float		sum( const float * src, uint32_t count );
+
+};
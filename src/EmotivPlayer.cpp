@@ -0,0 +1,167 @@
+/*
+* 
+* Copyright (c) 2012, Ban the Rewind
+* All rights reserved.
+* 
+* Redistribution and use in source and binary forms, with or 
+* without modification, are permitted provided that the following 
+* conditions are met:
+* 
+* Redistributions of source code must retain the above copyright 
+* notice, this list of conditions and the following disclaimer.
+* Redistributions in binary form must reproduce the above copyright 
+* notice, this list of conditions and the following disclaimer in 
+* the documentation and/or other materials provided with the 
+* distribution.
+* 
+* Neither the name of the Ban the Rewind nor the names of its 
+* contributors may be used to endorse or promote products 
+* derived from this software without specific prior written 
+* permission.
+* 
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS 
+* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT 
+* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS 
+* FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE 
+* COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, 
+* INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+* BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; 
+* LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+* CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, 
+* STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) 
+* ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF 
+* ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+* 
+*/
+
+// Include header
+#include "EmotivPlayer.h"
+
+// Imports
+using namespace ci;
+using namespace std;
+
+// Create pointer to player
+EmotivPlayerRef EmotivPlayer::create( const fs::path &path )
+{
+
+	// Map file
+	EmotivPlayerRef player( new EmotivPlayer() );
+	try {
+		player->mFile = boost::interprocess::file_mapping( path.string().c_str(), boost::interprocess::read_only );
+		player->mRegion = boost::interprocess::mapped_region( player->mFile, boost::interprocess::read_only );
+	} catch ( ... ) {
+		return EmotivPlayerRef();
+	}
+
+	// Check header and footer
+	const char * data = static_cast<const char *>( player->mRegion.get_address() );
+	size_t size = player->mRegion.get_size();
+	if ( size < sizeof( EmotivRecorder::FileHeader ) + sizeof( EmotivRecorder::Footer ) ) {
+		return EmotivPlayerRef();
+	}
+	const EmotivRecorder::FileHeader * header = reinterpret_cast<const EmotivRecorder::FileHeader *>( data );
+	const EmotivRecorder::Footer * footer = reinterpret_cast<const EmotivRecorder::Footer *>( data + size - sizeof( EmotivRecorder::Footer ) );
+	if ( memcmp( header->mMagic, "EMOTIVSN", 8 ) != 0 || header->mVersion != EmotivRecorder::VERSION || 
+		memcmp( footer->mMagic, "EMOTIVIX", 8 ) != 0 || footer->mIndexOffset < header->mHeaderSize || 
+		footer->mIndexOffset + footer->mIndexCount * sizeof( EmotivRecorder::IndexEntry ) + sizeof( EmotivRecorder::Footer ) != size ) {
+		return EmotivPlayerRef();
+	}
+
+	// Records sit between the header and the index
+	player->mHeader = header;
+	player->mBegin = data + header->mHeaderSize;
+	player->mEnd = data + footer->mIndexOffset;
+	player->mIndex = reinterpret_cast<const EmotivRecorder::IndexEntry *>( player->mEnd );
+	player->mIndexCount = footer->mIndexCount;
+	player->rewind();
+
+	// Scan the last page for the final timestamp
+	const char * position = player->mIndexCount > 0 ? data + player->mIndex[ player->mIndexCount - 1 ].mOffset : player->mBegin;
+	while ( position + sizeof( EmotivRecorder::RecordHeader ) <= player->mEnd ) {
+		const EmotivRecorder::RecordHeader * record = reinterpret_cast<const EmotivRecorder::RecordHeader *>( position );
+		player->mDuration = record->mTime;
+		position += sizeof( EmotivRecorder::RecordHeader ) + record->mSize;
+	}
+
+	return player;
+
+}
+
+// Constructor
+EmotivPlayer::EmotivPlayer()
+{
+	mBegin = 0;
+	mDuration = 0.0;
+	mEnd = 0;
+	mHeader = 0;
+	mIndex = 0;
+	mIndexCount = 0;
+	mPosition = 0;
+}
+
+// Destructor
+EmotivPlayer::~EmotivPlayer()
+{
+}
+
+// Read next record
+const EmotivRecorder::RecordHeader * EmotivPlayer::next( const char *& payload )
+{
+	const EmotivRecorder::RecordHeader * record = peek();
+	if ( record == 0 ) {
+		return 0;
+	}
+	payload = mPosition + sizeof( EmotivRecorder::RecordHeader );
+	mPosition = payload + record->mSize;
+	return record;
+}
+
+// Look at next record
+const EmotivRecorder::RecordHeader * EmotivPlayer::peek() const
+{
+
+	// Stop at the end or at a truncated record
+	if ( mPosition + sizeof( EmotivRecorder::RecordHeader ) > mEnd ) {
+		return 0;
+	}
+	const EmotivRecorder::RecordHeader * record = reinterpret_cast<const EmotivRecorder::RecordHeader *>( mPosition );
+	if ( mPosition + sizeof( EmotivRecorder::RecordHeader ) + record->mSize > mEnd ) {
+		return 0;
+	}
+	return record;
+
+}
+
+// Go back to start
+void EmotivPlayer::rewind()
+{
+	mPosition = mBegin;
+}
+
+// Seek to time
+void EmotivPlayer::seek( double time )
+{
+
+	// Find the last page starting at or before "time"
+	uint64_t low = 0;
+	uint64_t high = mIndexCount;
+	while ( low < high ) {
+		uint64_t mid = ( low + high ) / 2;
+		if ( mIndex[ mid ].mTime <= time ) {
+			low = mid + 1;
+		} else {
+			high = mid;
+		}
+	}
+	const char * data = static_cast<const char *>( mRegion.get_address() );
+	mPosition = low > 0 ? data + mIndex[ low - 1 ].mOffset : mBegin;
+
+	// Scan forward within the page
+	const EmotivRecorder::RecordHeader * record = peek();
+	while ( record != 0 && record->mTime < time ) {
+		mPosition += sizeof( EmotivRecorder::RecordHeader ) + record->mSize;
+		record = peek();
+	}
+
+}
@@ -0,0 +1,106 @@
+/*
+* 
+* Copyright (c) 2012, Ban the Rewind
+* All rights reserved.
+* 
+* Redistribution and use in source and binary forms, with or 
+* without modification, are permitted provided that the following 
+* conditions are met:
+* 
+* Redistributions of source code must retain the above copyright 
+* notice, this list of conditions and the following disclaimer.
+* Redistributions in binary form must reproduce the above copyright 
+* notice, this list of conditions and the following disclaimer in 
+* the documentation and/or other materials provided with the 
+* distribution.
+* 
+* Neither the name of the Ban the Rewind nor the names of its 
+* contributors may be used to endorse or promote products 
+* derived from this software without specific prior written 
+* permission.
+* 
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS 
+* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT 
+* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS 
+* FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE 
+* COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, 
+* INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+* BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; 
+* LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+* CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, 
+* STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) 
+* ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF 
+* ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+* 
+*/
+
+#pragma once
+
+// Includes
+#include "boost/interprocess/file_mapping.hpp"
+#include "boost/interprocess/mapped_region.hpp"
+#include "cinder/Cinder.h"
+#include "EmotivRecorder.h"
+
+// Player pointer alias
+typedef std::shared_ptr<class EmotivPlayer> EmotivPlayerRef;
+
+/*
+ * Reads a session file written by EmotivRecorder. The file is
+ * memory mapped and records are returned as pointers into the
+ * mapping, so stepping through a session does not copy or
+ * allocate.
+ */
+class EmotivPlayer
+{
+
+public:
+
+	// Create pointer to player. Returns an empty pointer if the 
+	// file cannot be mapped or is not a complete session.
+	static EmotivPlayerRef					create( const ci::fs::path &path );
+
+	// Destructor
+	~EmotivPlayer();
+
+	// File properties
+	double									getDuration() const { return mDuration; }
+	const EmotivRecorder::FileHeader &		getHeader() const { return *mHeader; }
+
+	// Returns true when every record has been read
+	bool									finished() const { return mPosition >= mEnd; }
+
+	// Returns the next record without consuming it, or 0 at the end
+	const EmotivRecorder::RecordHeader *	peek() const;
+
+	// Returns the next record and moves past it, or 0 at the end. 
+	// "payload" points at the record's data.
+	const EmotivRecorder::RecordHeader *	next( const char *& payload );
+
+	// Moves to the start of the first record
+	void									rewind();
+
+	// Moves to the first record at or after "time" seconds
+	void									seek( double time );
+
+private:
+
+	// Constructor
+	EmotivPlayer();
+
+	// Mapping
+	boost::interprocess::file_mapping		mFile;
+	boost::interprocess::mapped_region		mRegion;
+
+	// Layout
+	const char *							mBegin;
+	double									mDuration;
+	const char *							mEnd;
+	const EmotivRecorder::FileHeader *		mHeader;
+	const EmotivRecorder::IndexEntry *		mIndex;
+	uint64_t								mIndexCount;
+
+	// Read position
+	const char *							mPosition;
+
+};
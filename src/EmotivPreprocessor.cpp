@@ -0,0 +1,171 @@
+/*
+* 
+* Copyright (c) 2012, Ban the Rewind
+* All rights reserved.
+* 
+* Redistribution and use in source and binary forms, with or 
+* without modification, are permitted provided that the following 
+* conditions are met:
+* 
+* Redistributions of source code must retain the above copyright 
+* notice, this list of conditions and the following disclaimer.
+* Redistributions in binary form must reproduce the above copyright 
+* notice, this list of conditions and the following disclaimer in 
+* the documentation and/or other materials provided with the 
+* distribution.
+* 
+* Neither the name of the Ban the Rewind nor the names of its 
+* contributors may be used to endorse or promote products 
+* derived from this software without specific prior written 
+* permission.
+* 
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS 
+* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT 
+* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS 
+* FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE 
+* COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, 
+* INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+* BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; 
+* LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+* CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, 
+* STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) 
+* ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF 
+* ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+* 
+*/
+
+// Include header
+#include "EmotivPreprocessor.h"
+
+// Includes
+#include "cinder/CinderMath.h"
+
+// Imports
+using namespace ci;
+using namespace std;
+
+// High pass corner of DC removal in Hz, well under the delta band
+const float EmotivPreprocessor::DC_CUTOFF = 0.16f;
+
+// Notch quality. At 50Hz this cuts about 1.7Hz around the center.
+const float EmotivPreprocessor::NOTCH_Q = 30.0f;
+
+// Create pointer to preprocessor
+EmotivPreprocessorRef EmotivPreprocessor::create( uint32_t numChannels, float sampleRate )
+{
+	return EmotivPreprocessorRef( new EmotivPreprocessor( numChannels, sampleRate ) );
+}
+
+// Constructor
+EmotivPreprocessor::EmotivPreprocessor( uint32_t numChannels, float sampleRate )
+{
+
+	// Initialize state
+	mChannels.resize( numChannels );
+	mSampleRate = max( sampleRate, 1.0f );
+	reset();
+
+	// One-pole smoothing coefficient for the running mean
+	mDcCoefficient = 1.0 - math<double>::exp( -2.0 * M_PI * (double)DC_CUTOFF / (double)mSampleRate );
+	mDcRemoval = true;
+
+	// Notch starts off
+	mA1 = 0.0;
+	mA2 = 0.0;
+	mB0 = 1.0;
+	mB1 = 0.0;
+	mB2 = 0.0;
+	mNotch = false;
+	mNotchFrequency = 0.0f;
+
+}
+
+// Filter a run of samples
+void EmotivPreprocessor::process( uint32_t channel, float * samples, uint32_t count )
+{
+
+	// Bail if channel is out of range or there is nothing to do
+	if ( channel >= mChannels.size() || ( !mDcRemoval && !mNotch ) ) {
+		return;
+	}
+
+	// Filter in double precision, keeping state between blocks
+	Channel & state = mChannels[ channel ];
+	for ( uint32_t i = 0; i < count; i++ ) {
+		double value = samples[ i ];
+		if ( mDcRemoval ) {
+			if ( !state.mPrimed ) {
+				state.mMean = value;
+				state.mPrimed = true;
+			}
+			state.mMean += mDcCoefficient * ( value - state.mMean );
+			value -= state.mMean;
+		}
+		if ( mNotch ) {
+			double output = mB0 * value + state.mZ1;
+			state.mZ1 = mB1 * value - mA1 * output + state.mZ2;
+			state.mZ2 = mB2 * value - mA2 * output;
+			value = output;
+		}
+		samples[ i ] = static_cast<float>( value );
+	}
+
+}
+
+// Filter pending samples of every channel in a ring buffer
+void EmotivPreprocessor::process( EmotivRingBuffer &buffer, uint32_t count )
+{
+	uint32_t numChannels = min( buffer.getNumChannels(), getNumChannels() );
+	for ( uint32_t channel = 0; channel < numChannels; channel++ ) {
+		EmotivPreprocessor * preprocessor = this;
+		buffer.modify( channel, count, [ preprocessor, channel ]( float * samples, uint32_t runCount )
+		{
+			preprocessor->process( channel, samples, runCount );
+		} );
+	}
+}
+
+// Clear filter state
+void EmotivPreprocessor::reset()
+{
+	for ( vector<Channel>::iterator channelIt = mChannels.begin(); channelIt != mChannels.end(); ++channelIt ) {
+		channelIt->mMean = 0.0;
+		channelIt->mPrimed = false;
+		channelIt->mZ1 = 0.0;
+		channelIt->mZ2 = 0.0;
+	}
+}
+
+// Turn DC removal on or off
+void EmotivPreprocessor::setDcRemoval( bool enabled )
+{
+	if ( mDcRemoval != enabled ) {
+		mDcRemoval = enabled;
+		reset();
+	}
+}
+
+// Design the notch (RBJ audio EQ cookbook)
+void EmotivPreprocessor::setNotchFrequency( float frequency )
+{
+
+	// Turn off if out of range
+	mNotchFrequency = max( frequency, 0.0f );
+	mNotch = mNotchFrequency > 0.0f && mNotchFrequency < mSampleRate * 0.5f;
+	reset();
+	if ( !mNotch ) {
+		return;
+	}
+
+	// Normalized coefficients
+	double omega = 2.0 * M_PI * (double)mNotchFrequency / (double)mSampleRate;
+	double alpha = math<double>::sin( omega ) / ( 2.0 * (double)NOTCH_Q );
+	double cosine = math<double>::cos( omega );
+	double a0 = 1.0 + alpha;
+	mB0 = 1.0 / a0;
+	mB1 = -2.0 * cosine / a0;
+	mB2 = 1.0 / a0;
+	mA1 = -2.0 * cosine / a0;
+	mA2 = ( 1.0 - alpha ) / a0;
+
+}
@@ -0,0 +1,124 @@
+/*
+* 
+* Copyright (c) 2012, Ban the Rewind
+* All rights reserved.
+* 
+* Redistribution and use in source and binary forms, with or 
+* without modification, are permitted provided that the following 
+* conditions are met:
+* 
+* Redistributions of source code must retain the above copyright 
+* notice, this list of conditions and the following disclaimer.
+* Redistributions in binary form must reproduce the above copyright 
+* notice, this list of conditions and the following disclaimer in 
+* the documentation and/or other materials provided with the 
+* distribution.
+* 
+* Neither the name of the Ban the Rewind nor the names of its 
+* contributors may be used to endorse or promote products 
+* derived from this software without specific prior written 
+* permission.
+* 
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS 
+* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT 
+* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS 
+* FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE 
+* COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, 
+* INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+* BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; 
+* LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+* CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, 
+* STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) 
+* ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF 
+* ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+* 
+*/
+
+#pragma once
+
+// Includes
+#include "cinder/Cinder.h"
+#include "EmotivRingBuffer.h"
+#include <vector>
+
+// Preprocessor pointer alias
+typedef std::shared_ptr<class EmotivPreprocessor> EmotivPreprocessorRef;
+
+/*
+ * Streaming cleanup of raw EEG, run on each block as it is 
+ * acquired. Every channel keeps its own filter state, so blocks 
+ * can be fed one at a time with no edge effects between them.
+ *
+ * DC removal subtracts a running mean (a one-pole low pass at 
+ * DC_CUTOFF Hz, started at the first sample), taking out the 
+ * EPOC's electrode offset of around 4000uV before it can leak 
+ * into every FFT bin. The notch is a biquad centered on the mains 
+ * frequency, which otherwise shows up in the gamma band.
+ */
+class EmotivPreprocessor
+{
+
+public:
+
+	// Filter defaults
+	static const float				DC_CUTOFF;
+	static const float				NOTCH_Q;
+
+	// Create pointer to preprocessor
+	static EmotivPreprocessorRef	create( uint32_t numChannels, float sampleRate );
+
+	// DC removal, on by default
+	bool							getDcRemoval() const { return mDcRemoval; }
+	void							setDcRemoval( bool enabled );
+
+	// Mains notch. Set 50 or 60 to match local mains, or zero 
+	// (default) to turn it off. Frequencies at or above Nyquist 
+	// are ignored.
+	float							getNotchFrequency() const { return mNotchFrequency; }
+	void							setNotchFrequency( float frequency );
+
+	// Filters "count" samples of one channel in place
+	void							process( uint32_t channel, float * samples, uint32_t count );
+
+	// Filters the last "count" samples written to each channel of 
+	// "buffer" in place. Call between write() and commit().
+	void							process( EmotivRingBuffer &buffer, uint32_t count );
+
+	// Clears filter state, as after a gap in the signal
+	void							reset();
+
+	// Properties
+	uint32_t						getNumChannels() const { return static_cast<uint32_t>( mChannels.size() ); }
+	float							getSampleRate() const { return mSampleRate; }
+
+private:
+
+	// Constructor
+	EmotivPreprocessor( uint32_t numChannels, float sampleRate );
+
+	// Filter state of one channel
+	struct Channel
+	{
+		double	mMean;
+		bool	mPrimed;
+		double	mZ1;
+		double	mZ2;
+	};
+	std::vector<Channel>			mChannels;
+
+	// DC removal
+	double							mDcCoefficient;
+	bool							mDcRemoval;
+
+	// Notch, direct form II transposed
+	double							mA1;
+	double							mA2;
+	double							mB0;
+	double							mB1;
+	double							mB2;
+	bool							mNotch;
+	float							mNotchFrequency;
+
+	float							mSampleRate;
+
+};
@@ -0,0 +1,206 @@
+/*
+* 
+* Copyright (c) 2012, Ban the Rewind
+* All rights reserved.
+* 
+* Redistribution and use in source and binary forms, with or 
+* without modification, are permitted provided that the following 
+* conditions are met:
+* 
+* Redistributions of source code must retain the above copyright 
+* notice, this list of conditions and the following disclaimer.
+* Redistributions in binary form must reproduce the above copyright 
+* notice, this list of conditions and the following disclaimer in 
+* the documentation and/or other materials provided with the 
+* distribution.
+* 
+* Neither the name of the Ban the Rewind nor the names of its 
+* contributors may be used to endorse or promote products 
+* derived from this software without specific prior written 
+* permission.
+* 
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS 
+* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT 
+* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS 
+* FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE 
+* COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, 
+* INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+* BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; 
+* LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+* CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, 
+* STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) 
+* ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF 
+* ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+* 
+*/
+
+#pragma once
+
+// Includes
+#include "boost/thread/condition_variable.hpp"
+#include "boost/thread/mutex.hpp"
+#include "cinder/Cinder.h"
+#include <vector>
+
+/*
+ * Bounded FIFO used to hand items from the acquisition thread to
+ * a consumer thread. Storage is allocated once at creation. When
+ * the queue is full, the drop policy decides whether the oldest
+ * item is discarded, the new item is discarded, or the producer
+ * waits for room.
+ */
+template<typename T>
+class EmotivQueue
+{
+
+public:
+
+	// Drop policies
+	static const int32_t DROP_OLDEST =	0;
+	static const int32_t DROP_NEWEST =	1;
+	static const int32_t BLOCK =		2;
+
+	// Create pointer to queue
+	static std::shared_ptr<EmotivQueue<T> > create( uint32_t capacity, int32_t policy = DROP_OLDEST )
+	{
+		return std::shared_ptr<EmotivQueue<T> >( new EmotivQueue<T>( capacity, policy ) );
+	}
+
+	// Properties
+	uint32_t	getCapacity() const { return mCapacity; }
+	int32_t		getPolicy() const { return mPolicy; }
+
+	// Number of items waiting
+	uint32_t getDepth()
+	{
+		boost::mutex::scoped_lock lock( mMutex );
+		return mSize;
+	}
+
+	// Number of times an item was pushed into a full queue
+	uint64_t getOverflowCount()
+	{
+		boost::mutex::scoped_lock lock( mMutex );
+		return mOverflowCount;
+	}
+
+	// Releases a producer blocked on a full queue. Further 
+	// pushes are rejected.
+	void close()
+	{
+		{
+			boost::mutex::scoped_lock lock( mMutex );
+			mClosed = true;
+		}
+		mNotFull.notify_all();
+	}
+
+	// Accepts pushes again after close()
+	void open()
+	{
+		boost::mutex::scoped_lock lock( mMutex );
+		mClosed = false;
+	}
+
+	// Takes the oldest item. Returns false if the queue is empty.
+	bool pop( T &item )
+	{
+		{
+			boost::mutex::scoped_lock lock( mMutex );
+			if ( mSize == 0 ) {
+				return false;
+			}
+			item = mItems[ mHead ];
+			mHead = ( mHead + 1 ) % mCapacity;
+			mSize--;
+		}
+		mNotFull.notify_one();
+		return true;
+	}
+
+	// Adds an item. Returns false if it was dropped. With the BLOCK 
+	// policy, "release" is unlocked while waiting for room so the 
+	// consumer can take it, and locked again before returning.
+	bool push( const T &item, boost::mutex *release = 0 )
+	{
+
+		// Lock queue
+		boost::mutex::scoped_lock lock( mMutex );
+		if ( mClosed ) {
+			return false;
+		}
+
+		// Make room according to policy
+		if ( mSize == mCapacity ) {
+			mOverflowCount++;
+			if ( mPolicy == DROP_NEWEST ) {
+				return false;
+			} else if ( mPolicy == DROP_OLDEST ) {
+				mHead = ( mHead + 1 ) % mCapacity;
+				mSize--;
+			} else {
+
+				// Wait without the caller's lock. It is taken back 
+				// after the queue's own so locks are always taken 
+				// in the same order.
+				if ( release != 0 ) {
+					release->unlock();
+				}
+				while ( mSize == mCapacity && !mClosed ) {
+					mNotFull.wait( lock );
+				}
+				bool pushed = !mClosed;
+				if ( pushed ) {
+					append( item );
+				}
+				lock.unlock();
+				if ( release != 0 ) {
+					release->lock();
+				}
+				return pushed;
+
+			}
+		}
+
+		// Append item
+		append( item );
+		return true;
+
+	}
+
+private:
+
+	// Adds an item to the back. Call with the queue locked 
+	// and room available.
+	void append( const T &item )
+	{
+		mItems[ ( mHead + mSize ) % mCapacity ] = item;
+		mSize++;
+	}
+
+	// Constructor
+	EmotivQueue( uint32_t capacity, int32_t policy )
+	{
+		mCapacity = capacity > 0 ? capacity : 1;
+		mClosed = false;
+		mHead = 0;
+		mItems.resize( mCapacity );
+		mOverflowCount = 0;
+		mPolicy = policy;
+		mSize = 0;
+	}
+
+	// Items
+	uint32_t					mCapacity;
+	uint32_t					mHead;
+	std::vector<T>				mItems;
+	uint32_t					mSize;
+
+	// Flow control
+	bool						mClosed;
+	boost::mutex				mMutex;
+	boost::condition_variable	mNotFull;
+	uint64_t					mOverflowCount;
+	int32_t						mPolicy;
+
+};
@@ -0,0 +1,81 @@
+/*
+* 
+* Copyright (c) 2012, Ban the Rewind
+* All rights reserved.
+* 
+* Redistribution and use in source and binary forms, with or 
+* without modification, are permitted provided that the following 
+* conditions are met:
+* 
+* Redistributions of source code must retain the above copyright 
+* notice, this list of conditions and the following disclaimer.
+* Redistributions in binary form must reproduce the above copyright 
+* notice, this list of conditions and the following disclaimer in 
+* the documentation and/or other materials provided with the 
+* distribution.
+* 
+* Neither the name of the Ban the Rewind nor the names of its 
+* contributors may be used to endorse or promote products 
+* derived from this software without specific prior written 
+* permission.
+* 
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS 
+* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT 
+* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS 
+* FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE 
+* COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, 
+* INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+* BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; 
+* LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+* CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, 
+* STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) 
+* ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF 
+* ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+* 
+*/
+
+#pragma once
+
+// Includes
+#include "cinder/Cinder.h"
+
+/*
+ * Read-only view of a block of raw EEG, handed to raw callbacks 
+ * (see Emotiv::addRawCallback()). Sample "s" of channel "c" is at 
+ * mData[ c * mChannelStride + s * mSampleStride ]. Planar views 
+ * (mSampleStride of one) point straight into the user's ring 
+ * buffer. Interleaved views (mChannelStride of one) point into 
+ * a copy shared by every interleaved subscriber. Either way the 
+ * memory is only valid until the callback returns.
+ */
+struct EmotivRawView
+{
+
+	// Sample accessor
+	float			get( uint32_t channel, uint32_t sample ) const 
+	{ 
+		return mData[ channel * mChannelStride + sample * mSampleStride ]; 
+	}
+
+	// First sample of the first channel, and floats between 
+	// channels and between consecutive samples of one channel
+	const float *	mData;
+	uint32_t		mChannelStride;
+	uint32_t		mSampleStride;
+
+	// Block size
+	uint32_t		mNumChannels;
+	uint32_t		mSampleCount;
+
+	// Index of the first sample in the user's raw buffer. Blocks 
+	// follow each other without gaps, so a subscriber can tell a 
+	// missed block from this alone.
+	uint64_t		mFirstSample;
+	uint32_t		mUserId;
+
+	// When the first sample was taken, from the headset's 
+	// timestamps, in seconds on Emotiv's clock (see Emotiv::getTime()). 
+	// Later samples follow at the sample rate.
+	double			mTime;
+
+};
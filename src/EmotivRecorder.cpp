@@ -0,0 +1,276 @@
+/*
+* 
+* Copyright (c) 2012, Ban the Rewind
+* All rights reserved.
+* 
+* Redistribution and use in source and binary forms, with or 
+* without modification, are permitted provided that the following 
+* conditions are met:
+* 
+* Redistributions of source code must retain the above copyright 
+* notice, this list of conditions and the following disclaimer.
+* Redistributions in binary form must reproduce the above copyright 
+* notice, this list of conditions and the following disclaimer in 
+* the documentation and/or other materials provided with the 
+* distribution.
+* 
+* Neither the name of the Ban the Rewind nor the names of its 
+* contributors may be used to endorse or promote products 
+* derived from this software without specific prior written 
+* permission.
+* 
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS 
+* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT 
+* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS 
+* FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE 
+* COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, 
+* INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+* BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; 
+* LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+* CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, 
+* STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) 
+* ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF 
+* ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+* 
+*/
+
+// Include header
+#include "EmotivRecorder.h"
+#include "boost/bind.hpp"
+
+// Imports
+using namespace ci;
+using namespace std;
+
+// Create pointer to recorder
+EmotivRecorderRef EmotivRecorder::create( const fs::path &path, uint32_t eventSize, uint32_t channelCount, 
+	uint32_t sampleRate, double startTime, uint32_t pageSize )
+{
+
+	// Open file
+	EmotivRecorderRef recorder( new EmotivRecorder( pageSize ) );
+	recorder->mStartTime = startTime;
+	recorder->mFile.open( path.string().c_str(), ios::out | ios::binary | ios::trunc );
+	if ( !recorder->mFile.is_open() ) {
+		return EmotivRecorderRef();
+	}
+
+	// Write header
+	FileHeader header;
+	memcpy( header.mMagic, "EMOTIVSN", 8 );
+	header.mVersion = VERSION;
+	header.mHeaderSize = sizeof( FileHeader );
+	header.mEventSize = eventSize;
+	header.mChannelCount = channelCount;
+	header.mSampleRate = sampleRate;
+	header.mReserved = 0;
+	recorder->mFile.write( reinterpret_cast<const char *>( &header ), sizeof( FileHeader ) );
+	recorder->mFileOffset = sizeof( FileHeader );
+
+	// Start writer thread
+	recorder->mRunning = true;
+	recorder->mThread = std::shared_ptr<boost::thread>( new boost::thread( boost::bind( &EmotivRecorder::run, recorder.get() ) ) );
+
+	return recorder;
+
+}
+
+// Constructor
+EmotivRecorder::EmotivRecorder( uint32_t pageSize )
+{
+
+	// Allocate both pages up front
+	mPageSize = pageSize;
+	for ( int32_t i = 0; i < 2; i++ ) {
+		mPages[ i ].mData.resize( mPageSize );
+		mPages[ i ].mFirstTime = 0.0;
+		mPages[ i ].mFull = false;
+		mPages[ i ].mSize = 0;
+	}
+	mFront = &mPages[ 0 ];
+	mBack = &mPages[ 1 ];
+
+	// Initialize state
+	mDropCount = 0;
+	mFileOffset = 0;
+	mRunning = false;
+	mStartTime = 0.0;
+
+}
+
+// Destructor
+EmotivRecorder::~EmotivRecorder()
+{
+	stop();
+}
+
+// Get drop count
+uint64_t EmotivRecorder::getDropCount()
+{
+	boost::mutex::scoped_lock lock( mPageMutex );
+	return mDropCount;
+}
+
+// Append a record
+bool EmotivRecorder::record( uint32_t type, const void * data, uint32_t size, double time )
+{
+	boost::mutex::scoped_lock lock( mPageMutex );
+	char * payload = reserve( type, size, time );
+	if ( payload == 0 ) {
+		return false;
+	}
+	memcpy( payload, data, size );
+	return true;
+}
+
+// Append a raw block, copying straight from the ring into the page
+bool EmotivRecorder::recordRaw( uint32_t userId, const EmotivRingBuffer &buffer, uint64_t first, uint32_t count, double time )
+{
+
+	// Reserve space for header and samples
+	uint32_t channelCount = buffer.getNumChannels();
+	uint32_t size = sizeof( RawBlock ) + channelCount * count * sizeof( float );
+	boost::mutex::scoped_lock lock( mPageMutex );
+	char * payload = reserve( RECORD_RAW, size, time );
+	if ( payload == 0 ) {
+		return false;
+	}
+
+	// Fill in block
+	RawBlock block;
+	block.mUserId = userId;
+	block.mChannelCount = channelCount;
+	block.mSampleCount = count;
+	block.mReserved = 0;
+	block.mFirstSample = first;
+	memcpy( payload, &block, sizeof( RawBlock ) );
+	if ( buffer.readFrom( reinterpret_cast<float *>( payload + sizeof( RawBlock ) ), first, count ) < count ) {
+
+		// Samples are gone. Keep the record but mark it empty.
+		block.mSampleCount = 0;
+		memcpy( payload, &block, sizeof( RawBlock ) );
+
+	}
+	return true;
+
+}
+
+// Reserve room for a record in the front page
+char * EmotivRecorder::reserve( uint32_t type, uint32_t size, double time )
+{
+
+	// Bail if stopped or the record can never fit
+	uint32_t total = sizeof( RecordHeader ) + size;
+	if ( !mRunning || total > mPageSize ) {
+		mDropCount++;
+		return 0;
+	}
+
+	// Hand the front page to the writer when it fills up. If the 
+	// writer still has the other page, drop instead of waiting.
+	if ( mFront->mSize + total > mPageSize ) {
+		if ( mBack->mFull ) {
+			mDropCount++;
+			return 0;
+		}
+		mFront->mFull = true;
+		swap( mFront, mBack );
+		mCondition.notify_one();
+	}
+
+	// Write record header
+	RecordHeader header;
+	header.mType = type;
+	header.mSize = size;
+	header.mTime = time - mStartTime;
+	if ( mFront->mSize == 0 ) {
+		mFront->mFirstTime = header.mTime;
+	}
+	char * dest = &mFront->mData[ mFront->mSize ];
+	memcpy( dest, &header, sizeof( RecordHeader ) );
+	mFront->mSize += total;
+	return dest + sizeof( RecordHeader );
+
+}
+
+// Writer thread
+void EmotivRecorder::run()
+{
+
+	boost::mutex::scoped_lock lock( mPageMutex );
+	while ( true ) {
+
+		// Write full pages outside the lock
+		if ( mBack->mFull ) {
+			Page * page = mBack;
+			lock.unlock();
+			write( *page );
+			lock.lock();
+			page->mSize = 0;
+			page->mFull = false;
+			continue;
+		}
+
+		// Wait for a page or stop
+		if ( !mRunning ) {
+			break;
+		}
+		mCondition.wait( lock );
+
+	}
+
+	// Flush the partial page
+	if ( mFront->mSize > 0 ) {
+		write( *mFront );
+		mFront->mSize = 0;
+	}
+
+}
+
+// Stop recording and finish the file
+void EmotivRecorder::stop()
+{
+
+	// Stop writer. It flushes everything before exiting.
+	{
+		boost::mutex::scoped_lock lock( mPageMutex );
+		if ( !mRunning ) {
+			return;
+		}
+		mRunning = false;
+	}
+	mCondition.notify_all();
+	if ( mThread ) {
+		mThread->join();
+		mThread.reset();
+	}
+
+	// Write index and footer
+	Footer footer;
+	footer.mIndexOffset = mFileOffset;
+	footer.mIndexCount = mIndex.size();
+	memcpy( footer.mMagic, "EMOTIVIX", 8 );
+	if ( !mIndex.empty() ) {
+		mFile.write( reinterpret_cast<const char *>( &mIndex[ 0 ] ), mIndex.size() * sizeof( IndexEntry ) );
+	}
+	mFile.write( reinterpret_cast<const char *>( &footer ), sizeof( Footer ) );
+	mFile.close();
+	mIndex.clear();
+
+}
+
+// Write page to disk
+void EmotivRecorder::write( const Page &page )
+{
+
+	// Index the page by its first record
+	IndexEntry entry;
+	entry.mTime = page.mFirstTime;
+	entry.mOffset = mFileOffset;
+	mIndex.push_back( entry );
+
+	// Write records
+	mFile.write( &page.mData[ 0 ], page.mSize );
+	mFileOffset += page.mSize;
+
+}
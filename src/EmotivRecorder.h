@@ -0,0 +1,190 @@
+/*
+* 
+* Copyright (c) 2012, Ban the Rewind
+* All rights reserved.
+* 
+* Redistribution and use in source and binary forms, with or 
+* without modification, are permitted provided that the following 
+* conditions are met:
+* 
+* Redistributions of source code must retain the above copyright 
+* notice, this list of conditions and the following disclaimer.
+* Redistributions in binary form must reproduce the above copyright 
+* notice, this list of conditions and the following disclaimer in 
+* the documentation and/or other materials provided with the 
+* distribution.
+* 
+* Neither the name of the Ban the Rewind nor the names of its 
+* contributors may be used to endorse or promote products 
+* derived from this software without specific prior written 
+* permission.
+* 
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS 
+* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT 
+* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS 
+* FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE 
+* COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, 
+* INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+* BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; 
+* LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+* CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, 
+* STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) 
+* ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF 
+* ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+* 
+*/
+
+#pragma once
+
+// Includes
+#include "boost/thread/condition_variable.hpp"
+#include "boost/thread/mutex.hpp"
+#include "boost/thread/thread.hpp"
+#include "cinder/Cinder.h"
+#include "EmotivRingBuffer.h"
+#include <fstream>
+#include <vector>
+
+// Recorder pointer alias
+typedef std::shared_ptr<class EmotivRecorder> EmotivRecorderRef;
+
+/*
+ * Writes a session to a binary file. Records are appended to one of 
+ * two memory pages on the acquisition thread. A background thread 
+ * writes full pages to disk, so file I/O never blocks acquisition. 
+ * If both pages are full the record is dropped and counted.
+ *
+ * File layout:
+ *   FileHeader
+ *   RecordHeader + payload, repeated. Payload is an EmotivEvent 
+ *     (RECORD_EVENT) or a RawBlock followed by channelCount blocks 
+ *     of sampleCount floats (RECORD_RAW).
+ *   IndexEntry, one per page, mapping the time of the page's first 
+ *     record to its file offset
+ *   Footer
+ */
+class EmotivRecorder
+{
+
+public:
+
+	// Record types
+	static const uint32_t RECORD_EVENT =	1;
+	static const uint32_t RECORD_RAW =		2;
+
+	// File format version. Version 2 packs EmotivEvent into 84 bytes.
+	static const uint32_t VERSION =			2;
+
+	// Start of file
+	struct FileHeader
+	{
+		char		mMagic[ 8 ];	// "EMOTIVSN"
+		uint32_t	mVersion;
+		uint32_t	mHeaderSize;
+		uint32_t	mEventSize;		// sizeof( EmotivEvent ) when recorded
+		uint32_t	mChannelCount;
+		uint32_t	mSampleRate;
+		uint32_t	mReserved;
+	};
+
+	// Precedes each record. "mTime" is in seconds since recording 
+	// started, on the clock passed to create() and record().
+	struct RecordHeader
+	{
+		uint32_t	mType;
+		uint32_t	mSize;			// Payload bytes
+		double		mTime;
+	};
+
+	// Raw sample block payload header
+	struct RawBlock
+	{
+		uint32_t	mUserId;
+		uint32_t	mChannelCount;
+		uint32_t	mSampleCount;
+		uint32_t	mReserved;
+		uint64_t	mFirstSample;	// Index in the user's ring buffer
+	};
+
+	// Seek index entry
+	struct IndexEntry
+	{
+		double		mTime;
+		uint64_t	mOffset;
+	};
+
+	// End of file
+	struct Footer
+	{
+		uint64_t	mIndexOffset;
+		uint64_t	mIndexCount;
+		char		mMagic[ 8 ];	// "EMOTIVIX"
+	};
+
+	// Create pointer to recorder. "startTime" is the time recording 
+	// starts on the caller's clock, which every record's time is 
+	// then given on. Returns an empty pointer if the file cannot 
+	// be opened.
+	static EmotivRecorderRef	create( const ci::fs::path &path, uint32_t eventSize, uint32_t channelCount, 
+		uint32_t sampleRate, double startTime, uint32_t pageSize = 65536 );
+
+	// Destructor. Stops recording.
+	~EmotivRecorder();
+
+	// Records dropped because both pages were full
+	uint64_t					getDropCount();
+
+	// Appends a record made at "time". Returns false if it was dropped.
+	bool						record( uint32_t type, const void * data, uint32_t size, double time );
+
+	// Appends samples [ first, first + count ) of every channel 
+	// in "buffer", fetched at "time". Returns false if they were 
+	// dropped.
+	bool						recordRaw( uint32_t userId, const EmotivRingBuffer &buffer, uint64_t first, uint32_t count, double time );
+
+	// Flushes remaining records, writes the index and closes the 
+	// file. Called by the destructor.
+	void						stop();
+
+private:
+
+	// Constructor
+	EmotivRecorder( uint32_t pageSize );
+
+	// A page of records
+	struct Page
+	{
+		std::vector<char>		mData;
+		double					mFirstTime;
+		bool					mFull;
+		uint32_t				mSize;
+	};
+
+	// Reserves "size" bytes for a record in the front page. Returns 
+	// 0 if there is no room. Call with the page mutex locked.
+	char *						reserve( uint32_t type, uint32_t size, double time );
+
+	// Writes a page to disk and indexes it
+	void						write( const Page &page );
+
+	// File
+	std::ofstream				mFile;
+	uint64_t					mFileOffset;
+	std::vector<IndexEntry>		mIndex;
+	double						mStartTime;
+
+	// Double-buffered pages
+	Page						mPages[ 2 ];
+	Page *						mBack;
+	uint64_t					mDropCount;
+	Page *						mFront;
+	boost::mutex				mPageMutex;
+	uint32_t					mPageSize;
+
+	// Writer thread
+	boost::condition_variable		mCondition;
+	bool							mRunning;
+	std::shared_ptr<boost::thread>	mThread;
+	void							run();
+
+};
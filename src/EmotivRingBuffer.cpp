@@ -0,0 +1,266 @@
+/*
+* 
+* Copyright (c) 2012, Ban the Rewind
+* All rights reserved.
+* 
+* Redistribution and use in source and binary forms, with or 
+* without modification, are permitted provided that the following 
+* conditions are met:
+* 
+* Redistributions of source code must retain the above copyright 
+* notice, this list of conditions and the following disclaimer.
+* Redistributions in binary form must reproduce the above copyright 
+* notice, this list of conditions and the following disclaimer in 
+* the documentation and/or other materials provided with the 
+* distribution.
+* 
+* Neither the name of the Ban the Rewind nor the names of its 
+* contributors may be used to endorse or promote products 
+* derived from this software without specific prior written 
+* permission.
+* 
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS 
+* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT 
+* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS 
+* FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE 
+* COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, 
+* INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+* BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; 
+* LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+* CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, 
+* STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) 
+* ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF 
+* ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+* 
+*/
+
+// Include header
+#include "EmotivRingBuffer.h"
+
+// Includes
+#include "EmotivKernels.h"
+
+// Imports
+using namespace std;
+
+// Number of times a read is retried after being overtaken
+static const int32_t MAX_READ_ATTEMPTS = 4;
+
+// Create pointer to ring buffer
+EmotivRingBufferRef EmotivRingBuffer::create( uint32_t numChannels, uint32_t capacity )
+{
+	return EmotivRingBufferRef( new EmotivRingBuffer( numChannels, capacity ) );
+}
+
+// Constructor
+EmotivRingBuffer::EmotivRingBuffer( uint32_t numChannels, uint32_t capacity )
+{
+
+	// Round capacity up to a power of two so positions wrap with a mask
+	mCapacity = 1;
+	while ( mCapacity < capacity ) {
+		mCapacity <<= 1;
+	}
+	mMask = mCapacity - 1;
+
+	// Allocate storage up front, one block per channel
+	mNumChannels = numChannels;
+	mData.resize( mNumChannels * mCapacity, 0.0f );
+
+	// Nothing written yet
+	mReserved.store( 0 );
+	mWritten.store( 0 );
+
+}
+
+// Destructor
+EmotivRingBuffer::~EmotivRingBuffer()
+{
+	mData.clear();
+}
+
+// Publish samples written since the last commit
+void EmotivRingBuffer::commit( uint32_t count )
+{
+	uint64_t written = mWritten.load( boost::memory_order_relaxed ) + count;
+	mReserved.store( written, boost::memory_order_relaxed );
+	mWritten.store( written, boost::memory_order_release );
+}
+
+// Copy samples out of one channel, splitting at the wrap point
+void EmotivRingBuffer::copy( uint32_t channel, uint64_t first, uint32_t count, float * dest ) const
+{
+	const float * data = &mData[ channel * mCapacity ];
+	uint32_t offset = static_cast<uint32_t>( first & mMask );
+	uint32_t head = min( count, mCapacity - offset );
+	memcpy( dest, data + offset, head * sizeof( float ) );
+	if ( head < count ) {
+		memcpy( dest + head, data, ( count - head ) * sizeof( float ) );
+	}
+}
+
+// Point at a contiguous run of committed samples
+const float * EmotivRingBuffer::getRun( uint64_t first, uint32_t & count ) const
+{
+	uint64_t written = mWritten.load( boost::memory_order_acquire );
+	if ( count == 0 || first + count > written || first + mCapacity < written ) {
+		count = 0;
+		return 0;
+	}
+	uint32_t offset = static_cast<uint32_t>( first & mMask );
+	count = min( count, mCapacity - offset );
+	return &mData[ offset ];
+}
+
+// Get total samples written
+uint64_t EmotivRingBuffer::getWriteCount() const
+{
+	return mWritten.load( boost::memory_order_acquire );
+}
+
+// Read latest samples from one channel
+uint32_t EmotivRingBuffer::read( uint32_t channel, float * dest, uint32_t count, uint64_t * firstSample ) const
+{
+
+	// Bail if channel is out of range
+	if ( channel >= mNumChannels ) {
+		return 0;
+	}
+
+	// Try a few times in case the writer laps us
+	uint64_t first = 0;
+	for ( int32_t i = 0; i < MAX_READ_ATTEMPTS; i++ ) {
+		uint32_t copied = count;
+		if ( tryRead( channel, channel + 1, dest, copied, first ) ) {
+			if ( firstSample != 0 ) {
+				*firstSample = first;
+			}
+			return copied;
+		}
+	}
+	return 0;
+
+}
+
+// Read latest samples from all channels
+uint32_t EmotivRingBuffer::read( float * dest, uint32_t count, uint64_t * firstSample ) const
+{
+	uint64_t first = 0;
+	for ( int32_t i = 0; i < MAX_READ_ATTEMPTS; i++ ) {
+		uint32_t copied = count;
+		if ( tryRead( 0, mNumChannels, dest, copied, first ) ) {
+			if ( firstSample != 0 ) {
+				*firstSample = first;
+			}
+			return copied;
+		}
+	}
+	return 0;
+}
+
+// Read a fixed range from all channels
+uint32_t EmotivRingBuffer::readFrom( float * dest, uint64_t first, uint32_t count ) const
+{
+
+	// Range must be written and still in the ring
+	uint64_t written = mWritten.load( boost::memory_order_acquire );
+	if ( count > mCapacity || first + count > written || first + mCapacity < written ) {
+		return 0;
+	}
+
+	// Copy each channel into its own block
+	for ( uint32_t channel = 0; channel < mNumChannels; channel++ ) {
+		copy( channel, first, count, dest + channel * count );
+	}
+
+	// Check that the writer did not reach the range while copying
+	boost::atomic_thread_fence( boost::memory_order_acquire );
+	uint64_t reserved = mReserved.load( boost::memory_order_relaxed );
+	return first + mCapacity >= reserved ? count : 0;
+
+}
+
+// Copy the newest samples, then verify the writer has not 
+// started overwriting any of them in the meantime
+bool EmotivRingBuffer::tryRead( uint32_t begin, uint32_t end, float * dest, uint32_t & count, uint64_t & first ) const
+{
+
+	// Clamp request to what is available. Channel blocks keep
+	// the requested stride.
+	uint32_t stride = count;
+	uint64_t written = mWritten.load( boost::memory_order_acquire );
+	count = static_cast<uint32_t>( min<uint64_t>( count, min<uint64_t>( written, mCapacity ) ) );
+	first = written - count;
+
+	// Copy each channel into its own block
+	for ( uint32_t channel = begin; channel < end; channel++ ) {
+		copy( channel, first, count, dest + ( channel - begin ) * stride );
+	}
+
+	// Samples below "reserved - capacity" may have been overwritten
+	boost::atomic_thread_fence( boost::memory_order_acquire );
+	uint64_t reserved = mReserved.load( boost::memory_order_relaxed );
+	return first + mCapacity >= reserved;
+
+}
+
+// Copy contiguous samples into the ring as float
+static void storeSamples( const double * src, float * dest, uint32_t count )
+{
+	EmotivKernels::convert( src, dest, count );
+}
+
+static void storeSamples( const float * src, float * dest, uint32_t count )
+{
+	memcpy( dest, src, count * sizeof( float ) );
+}
+
+// Store a block of samples for one channel. Samples are not
+// visible to readers until commit() is called.
+template<typename T>
+void EmotivRingBuffer::store( uint32_t channel, const T * data, uint32_t count )
+{
+
+	// Bail if channel is out of range
+	if ( channel >= mNumChannels || count == 0 ) {
+		return;
+	}
+
+	// Only the newest "capacity" samples of an oversized block fit
+	uint64_t written = mWritten.load( boost::memory_order_relaxed );
+	uint64_t end = written + count;
+	if ( count > mCapacity ) {
+		data += count - mCapacity;
+		written = end - mCapacity;
+		count = mCapacity;
+	}
+
+	// Reserve the slots before touching them so readers 
+	// can tell their data is going away
+	if ( mReserved.load( boost::memory_order_relaxed ) < end ) {
+		mReserved.store( end, boost::memory_order_relaxed );
+		boost::atomic_thread_fence( boost::memory_order_release );
+	}
+
+	// Convert and store samples, splitting at the wrap point
+	float * dest = &mData[ channel * mCapacity ];
+	uint32_t offset = static_cast<uint32_t>( written & mMask );
+	uint32_t head = min( count, mCapacity - offset );
+	storeSamples( data, dest + offset, head );
+	if ( head < count ) {
+		storeSamples( data + head, dest, count - head );
+	}
+
+}
+
+// Write double samples
+void EmotivRingBuffer::write( uint32_t channel, const double * data, uint32_t count )
+{
+	store( channel, data, count );
+}
+
+// Write float samples
+void EmotivRingBuffer::write( uint32_t channel, const float * data, uint32_t count )
+{
+	store( channel, data, count );
+}
@@ -0,0 +1,153 @@
+/*
+* 
+* Copyright (c) 2012, Ban the Rewind
+* All rights reserved.
+* 
+* Redistribution and use in source and binary forms, with or 
+* without modification, are permitted provided that the following 
+* conditions are met:
+* 
+* Redistributions of source code must retain the above copyright 
+* notice, this list of conditions and the following disclaimer.
+* Redistributions in binary form must reproduce the above copyright 
+* notice, this list of conditions and the following disclaimer in 
+* the documentation and/or other materials provided with the 
+* distribution.
+* 
+* Neither the name of the Ban the Rewind nor the names of its 
+* contributors may be used to endorse or promote products 
+* derived from this software without specific prior written 
+* permission.
+* 
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS 
+* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT 
+* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS 
+* FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE 
+* COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, 
+* INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+* BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; 
+* LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+* CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, 
+* STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) 
+* ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF 
+* ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+* 
+*/
+
+#pragma once
+
+// Includes
+#include "boost/atomic.hpp"
+#include "cinder/Cinder.h"
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+// Ring buffer pointer alias
+typedef std::shared_ptr<class EmotivRingBuffer> EmotivRingBufferRef;
+
+/*
+ * Fixed-capacity raw EEG buffer with a single writer. Each
+ * channel occupies its own contiguous block. The acquisition
+ * thread writes samples and then publishes the new write
+ * position. Readers on any thread copy the most recent samples
+ * without taking a lock. A read that was overtaken by the writer
+ * while copying is detected and retried.
+ */
+class EmotivRingBuffer
+{
+
+public:
+
+	// Create pointer to ring buffer. Capacity is rounded up
+	// to the next power of two.
+	static EmotivRingBufferRef	create( uint32_t numChannels, uint32_t capacity );
+
+	// Destructor
+	~EmotivRingBuffer();
+
+	// Properties
+	uint32_t					getCapacity() const { return mCapacity; }
+	uint32_t					getNumChannels() const { return mNumChannels; }
+
+	// Total number of samples written since creation. The
+	// newest sample has index getWriteCount() - 1.
+	uint64_t					getWriteCount() const;
+
+	// Writer. Fill each channel with write(), then publish the
+	// block with commit(). Only the acquisition thread may call these.
+	void						write( uint32_t channel, const double * data, uint32_t count );
+	void						write( uint32_t channel, const float * data, uint32_t count );
+	void						commit( uint32_t count );
+
+	// Lets the writer change the last "count" samples written to 
+	// a channel in place before they are committed. "filter" is 
+	// called as filter( float * samples, uint32_t count ) once per 
+	// contiguous run, oldest first.
+	template<typename T>
+	void						modify( uint32_t channel, uint32_t count, const T &filter )
+	{
+		if ( channel >= mNumChannels || count == 0 ) {
+			return;
+		}
+		count = std::min( count, mCapacity );
+		uint64_t first = mReserved.load( boost::memory_order_relaxed ) - count;
+		float * data = &mData[ channel * mCapacity ];
+		uint32_t offset = static_cast<uint32_t>( first & mMask );
+		uint32_t head = std::min( count, mCapacity - offset );
+		filter( data + offset, head );
+		if ( head < count ) {
+			filter( data, count - head );
+		}
+	}
+
+	// Readers. Copy up to "count" of the most recent samples, oldest
+	// first, and return the number copied. "dest" must hold "count"
+	// floats per channel read. The multi-channel read stores each
+	// channel in its own block of "count" floats, even if fewer
+	// samples were available. If "firstSample"
+	// is set it receives the index of the first sample copied.
+	uint32_t					read( uint32_t channel, float * dest, uint32_t count, uint64_t * firstSample = 0 ) const;
+	uint32_t					read( float * dest, uint32_t count, uint64_t * firstSample = 0 ) const;
+
+	// Copies samples [ first, first + count ) of every channel, one 
+	// block per channel. Returns zero if any of them have not been 
+	// written yet or have already been overwritten.
+	uint32_t					readFrom( float * dest, uint64_t first, uint32_t count ) const;
+
+	// Points at sample "first" of channel zero without copying. 
+	// Other channels follow every getCapacity() floats. "count" is 
+	// cut short where the run wraps around the end of the ring. 
+	// Returns null if the samples are not all there. Nothing stops 
+	// the writer from overwriting them, so only use this on the 
+	// writer's thread.
+	const float *				getRun( uint64_t first, uint32_t & count ) const;
+
+private:
+
+	// Constructor
+	EmotivRingBuffer( uint32_t numChannels, uint32_t capacity );
+
+	// Copies one channel's samples [ first, first + count ) out of the ring
+	void						copy( uint32_t channel, uint64_t first, uint32_t count, float * dest ) const;
+
+	// Stores samples of any type as float
+	template<typename T> 
+	void						store( uint32_t channel, const T * data, uint32_t count );
+
+	// Copies the latest samples of channels [ begin, end ), returns
+	// false if the writer overtook the read
+	bool						tryRead( uint32_t begin, uint32_t end, float * dest, uint32_t & count, uint64_t & first ) const;
+
+	// Sample storage
+	uint32_t					mCapacity;
+	std::vector<float>			mData;
+	uint32_t					mMask;
+	uint32_t					mNumChannels;
+
+	// Write positions. "mReserved" moves before new samples
+	// are written, "mWritten" after. Readers check both.
+	boost::atomic<uint64_t>		mReserved;
+	boost::atomic<uint64_t>		mWritten;
+
+};
@@ -0,0 +1,348 @@
+/*
+* 
+* Copyright (c) 2012, Ban the Rewind
+* All rights reserved.
+* 
+* Redistribution and use in source and binary forms, with or 
+* without modification, are permitted provided that the following 
+* conditions are met:
+* 
+* Redistributions of source code must retain the above copyright 
+* notice, this list of conditions and the following disclaimer.
+* Redistributions in binary form must reproduce the above copyright 
+* notice, this list of conditions and the following disclaimer in 
+* the documentation and/or other materials provided with the 
+* distribution.
+* 
+* Neither the name of the Ban the Rewind nor the names of its 
+* contributors may be used to endorse or promote products 
+* derived from this software without specific prior written 
+* permission.
+* 
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS 
+* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT 
+* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS 
+* FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE 
+* COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, 
+* INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+* BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; 
+* LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+* CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, 
+* STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) 
+* ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF 
+* ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+* 
+*/
+
+// Include header
+#include "EmotivSimulator.h"
+
+// Includes
+#include "cinder/CinderMath.h"
+
+// Imports
+using namespace ci;
+using namespace std;
+
+// Spacing of the tones that make up a band, in Hz
+static const float BAND_TONE_SPACING = 0.25f;
+
+// Cognitiv actions picked from at random
+static const int32_t COGNITIV_ACTION_COUNT = 7;
+static const int32_t COGNITIV_ACTIONS[ COGNITIV_ACTION_COUNT ] = {
+	EmotivEvent::COG_NEUTRAL, 
+	EmotivEvent::COG_PUSH, 
+	EmotivEvent::COG_PULL, 
+	EmotivEvent::COG_LIFT, 
+	EmotivEvent::COG_DROP, 
+	EmotivEvent::COG_LEFT, 
+	EmotivEvent::COG_RIGHT
+};
+
+// Create pointer to simulator
+EmotivSimulatorRef EmotivSimulator::create( uint32_t numUsers, uint32_t sampleRate )
+{
+	return EmotivSimulatorRef( new EmotivSimulator( numUsers, sampleRate ) );
+}
+
+// Constructor
+EmotivSimulator::EmotivSimulator( uint32_t numUsers, uint32_t sampleRate )
+{
+
+	// Initialize settings. The default signal is a 10Hz 
+	// alpha rhythm over a little noise.
+	mNoise = 5.0f;
+	mOffset = 4200.0f;
+	mPacketLoss = 0.0f;
+	mSampleRate = max<uint32_t>( sampleRate, 1 );
+	mStateRate = 8.0f;
+	addTone( 10.0f, 20.0f );
+
+	// Initialize session
+	mConnected = false;
+	mNextUser = 0;
+	mUsers.resize( numUsers );
+
+	// Hold one second of samples until told otherwise
+	setDataBufferSize( 1.0 );
+
+}
+
+// Destructor
+EmotivSimulator::~EmotivSimulator()
+{
+}
+
+// Add band-limited content
+void EmotivSimulator::addBand( float lowFrequency, float highFrequency, float amplitude, int32_t channel )
+{
+
+	// Build the band from closely spaced tones with random 
+	// phases, splitting the power evenly between them
+	int32_t count = max( static_cast<int32_t>( ( highFrequency - lowFrequency ) / BAND_TONE_SPACING ), 1 );
+	float toneAmplitude = amplitude * math<float>::sqrt( 2.0f / (float)count );
+	for ( int32_t i = 0; i < count; i++ ) {
+		Tone tone;
+		tone.mAmplitude = toneAmplitude;
+		tone.mChannel = channel;
+		tone.mFrequency = lowFrequency + ( (float)i + 0.5f ) * ( highFrequency - lowFrequency ) / (float)count;
+		tone.mPhase = mRand.nextFloat( (float)M_PI * 2.0f );
+		mTones.push_back( tone );
+	}
+
+}
+
+// Add sine tone
+void EmotivSimulator::addTone( float frequency, float amplitude, int32_t channel )
+{
+	Tone tone;
+	tone.mAmplitude = amplitude;
+	tone.mChannel = channel;
+	tone.mFrequency = frequency;
+	tone.mPhase = 0.0f;
+	mTones.push_back( tone );
+}
+
+// Remove tones and bands
+void EmotivSimulator::clearSignal()
+{
+	mTones.clear();
+}
+
+// Start simulated session
+bool EmotivSimulator::connect( const string &/* deviceId */, const string &/* remoteAddress */, uint16_t /* port */ )
+{
+	mConnected = true;
+	mNextUser = 0;
+	mTimer.start();
+	for ( vector<User>::iterator userIt = mUsers.begin(); userIt != mUsers.end(); ++userIt ) {
+		userIt->mAdded = false;
+		userIt->mDataCount = 0;
+		userIt->mNextStateTime = 0.0;
+		userIt->mSampleCount = 0;
+	}
+	return true;
+}
+
+// Simulated users are never removed
+void EmotivSimulator::disableData( uint32_t /* userId */ )
+{
+}
+
+// End simulated session
+bool EmotivSimulator::disconnect()
+{
+	mConnected = false;
+	return true;
+}
+
+// All users stream at the same rate
+uint32_t EmotivSimulator::enableData( uint32_t /* userId */ )
+{
+	return mSampleRate;
+}
+
+// Copy latched samples of an EEG channel
+void EmotivSimulator::getData( uint32_t userId, int32_t channel, double * dest, uint32_t count )
+{
+	if ( userId >= mUsers.size() || channel < 0 || channel > CHANNEL_TIMESTAMP ) {
+		return;
+	}
+	const User & user = mUsers[ userId ];
+	count = min( count, user.mDataCount );
+	if ( count > 0 ) {
+		memcpy( dest, &user.mData[ channel * mDataCapacity ], count * sizeof( double ) );
+	}
+}
+
+// Generate next event
+int32_t EmotivSimulator::getNextEvent( uint32_t &userId, EmotivEvent &event )
+{
+
+	// Bail if not connected
+	if ( !mConnected || mUsers.empty() ) {
+		return EVENT_NONE;
+	}
+
+	// Announce each headset first
+	for ( uint32_t i = 0; i < mUsers.size(); i++ ) {
+		if ( !mUsers[ i ].mAdded ) {
+			mUsers[ i ].mAdded = true;
+			userId = i;
+			return EVENT_USER_ADDED;
+		}
+	}
+
+	// Visit users in turn so none of them starve
+	double time = getTime();
+	double period = 1.0 / (double)max( mStateRate, 0.001f );
+	for ( uint32_t i = 0; i < mUsers.size(); i++ ) {
+		userId = ( mNextUser + i ) % mUsers.size();
+		User & user = mUsers[ userId ];
+		if ( time < user.mNextStateTime ) {
+			continue;
+		}
+		mNextUser = userId + 1;
+
+		// Schedule the next state, catching up if we fell behind
+		user.mNextStateTime += period;
+		if ( user.mNextStateTime < time ) {
+			user.mNextStateTime = time + period;
+		}
+
+		// Affectiv scores drift slowly, everything else is random
+		float drift = math<float>::sin( (float)time * 0.1f + (float)userId );
+		event = EmotivEvent(
+			(float)time, 
+			userId, 
+			EmotivEvent::GOOD_SIGNAL, 
+			mRand.nextFloat() < 0.05f ? 1 : 0, 
+			mRand.nextFloat() < 0.02f ? 1 : 0, 
+			mRand.nextFloat() < 0.02f ? 1 : 0, 
+			mRand.nextFloat() < 0.05f ? 1 : 0, 
+			mRand.nextFloat() < 0.05f ? 1 : 0, 
+			mRand.nextFloat(), 
+			mRand.nextFloat(), 
+			mRand.nextFloat(), 
+			mRand.nextFloat(), 
+			mRand.nextFloat(), 
+			mRand.nextFloat(), 
+			mRand.nextFloat(), 
+			0.5f + 0.4f * drift + mRand.nextFloat( -0.1f, 0.1f ), 
+			0.5f + 0.4f * drift, 
+			0.5f - 0.4f * drift + mRand.nextFloat( -0.1f, 0.1f ), 
+			COGNITIV_ACTIONS[ mRand.nextInt( COGNITIV_ACTION_COUNT ) ], 
+			mRand.nextFloat()
+			);
+		return EVENT_STATE_UPDATED;
+
+	}
+
+	// Nothing due yet
+	return EVENT_NONE;
+
+}
+
+// Get number of simulated headsets
+uint32_t EmotivSimulator::getNumUsers()
+{
+	return mConnected ? mUsers.size() : 0;
+}
+
+// Seconds since connecting
+double EmotivSimulator::getTime() const
+{
+	return mTimer.getSeconds();
+}
+
+// There are no profiles to load
+bool EmotivSimulator::loadProfile( const fs::path &/* profilePath */, uint32_t /* userId */ )
+{
+	return false;
+}
+
+// Set size of the latch buffer
+void EmotivSimulator::setDataBufferSize( double seconds )
+{
+	mDataCapacity = max( static_cast<uint32_t>( math<double>::ceil( seconds * (double)mSampleRate ) ), 1u );
+	for ( vector<User>::iterator userIt = mUsers.begin(); userIt != mUsers.end(); ++userIt ) {
+		userIt->mData.resize( mDataCapacity * ( EEG_CHANNEL_COUNT + 2 ) );
+		userIt->mDataCount = 0;
+	}
+}
+
+// Set noise amplitude
+void EmotivSimulator::setNoise( float amplitude )
+{
+	mNoise = max( amplitude, 0.0f );
+}
+
+// Set DC offset
+void EmotivSimulator::setOffset( float offset )
+{
+	mOffset = offset;
+}
+
+// Set packet loss
+void EmotivSimulator::setPacketLoss( float probability )
+{
+	mPacketLoss = math<float>::clamp( probability, 0.0f, 1.0f );
+}
+
+// Seed random generator
+void EmotivSimulator::setSeed( uint32_t seed )
+{
+	mRand.seed( seed );
+}
+
+// Set EmoState rate
+void EmotivSimulator::setStateRate( float rate )
+{
+	mStateRate = max( rate, 0.001f );
+}
+
+// Generate the samples a user's headset has sent since the last call
+uint32_t EmotivSimulator::updateData( uint32_t userId )
+{
+
+	// Bail if the user does not exist
+	if ( !mConnected || userId >= mUsers.size() ) {
+		return 0;
+	}
+
+	// Work out how many samples are due. Like the EDK, only 
+	// the most recent buffer's worth is kept.
+	User & user = mUsers[ userId ];
+	user.mDataCount = 0;
+	uint64_t target = static_cast<uint64_t>( getTime() * (double)mSampleRate );
+	if ( target <= user.mSampleCount ) {
+		return 0;
+	}
+	if ( target - user.mSampleCount > mDataCapacity ) {
+		user.mSampleCount = target - mDataCapacity;
+	}
+
+	// Synthesize each sample that was not lost
+	float twoPi = (float)M_PI * 2.0f;
+	float userPhase = (float)userId * 0.5f;
+	for ( ; user.mSampleCount < target; user.mSampleCount++ ) {
+		if ( mPacketLoss > 0.0f && mRand.nextFloat() < mPacketLoss ) {
+			continue;
+		}
+		double time = (double)user.mSampleCount / (double)mSampleRate;
+		for ( int32_t channel = 0; channel < EEG_CHANNEL_COUNT; channel++ ) {
+			double value = mOffset + mRand.nextFloat( -mNoise, mNoise );
+			for ( vector<Tone>::const_iterator toneIt = mTones.begin(); toneIt != mTones.end(); ++toneIt ) {
+				if ( toneIt->mChannel < 0 || toneIt->mChannel == channel ) {
+					value += toneIt->mAmplitude * math<double>::sin( twoPi * toneIt->mFrequency * time + toneIt->mPhase + userPhase );
+				}
+			}
+			user.mData[ channel * mDataCapacity + user.mDataCount ] = value;
+		}
+		user.mData[ CHANNEL_COUNTER * mDataCapacity + user.mDataCount ] = (double)( user.mSampleCount % COUNTER_RANGE );
+		user.mData[ CHANNEL_TIMESTAMP * mDataCapacity + user.mDataCount ] = time;
+		user.mDataCount++;
+	}
+	return user.mDataCount;
+
+}
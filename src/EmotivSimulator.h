@@ -0,0 +1,160 @@
+/*
+* 
+* Copyright (c) 2012, Ban the Rewind
+* All rights reserved.
+* 
+* Redistribution and use in source and binary forms, with or 
+* without modification, are permitted provided that the following 
+* conditions are met:
+* 
+* Redistributions of source code must retain the above copyright 
+* notice, this list of conditions and the following disclaimer.
+* Redistributions in binary form must reproduce the above copyright 
+* notice, this list of conditions and the following disclaimer in 
+* the documentation and/or other materials provided with the 
+* distribution.
+* 
+* Neither the name of the Ban the Rewind nor the names of its 
+* contributors may be used to endorse or promote products 
+* derived from this software without specific prior written 
+* permission.
+* 
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS 
+* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT 
+* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS 
+* FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE 
+* COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, 
+* INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+* BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; 
+* LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+* CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, 
+* STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) 
+* ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF 
+* ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+* 
+*/
+
+#pragma once
+
+// Includes
+#include "cinder/Rand.h"
+#include "cinder/Timer.h"
+#include "EmotivEngine.h"
+#include <vector>
+
+// Simulator pointer alias
+typedef std::shared_ptr<class EmotivSimulator> EmotivSimulatorRef;
+
+/*
+ * Engine that generates synthetic EmoStates and 14-channel EEG 
+ * for any number of users, paced by its own clock from connect() 
+ * on, so it runs without a Cinder application. The 
+ * EEG is a sum of sine tones and band-limited content plus 
+ * white noise. Samples can be dropped at random to imitate 
+ * wireless packet loss. Configure the simulator before passing 
+ * it to Emotiv::create() or, at the latest, before connect().
+ */
+class EmotivSimulator : public EmotivEngine
+{
+
+public:
+
+	// Create pointer to simulator with "numUsers" headsets 
+	// sampling at "sampleRate"
+	static EmotivSimulatorRef	create( uint32_t numUsers = 1, uint32_t sampleRate = 128 );
+
+	// Destructor
+	~EmotivSimulator();
+
+	// Adds a sine tone of "amplitude" microvolts at "frequency" Hz to 
+	// "channel", or to every channel if it is negative
+	void		addTone( float frequency, float amplitude, int32_t channel = -1 );
+
+	// Adds content spread evenly between "lowFrequency" and 
+	// "highFrequency" Hz with an RMS of "amplitude" microvolts
+	void		addBand( float lowFrequency, float highFrequency, float amplitude, int32_t channel = -1 );
+
+	// Removes all tones and bands
+	void		clearSignal();
+
+	// Constant offset added to every sample, in microvolts. The 
+	// EPOC reports values around 4200.
+	float		getOffset() const { return mOffset; }
+	void		setOffset( float offset );
+
+	// Peak amplitude of white noise, in microvolts
+	float		getNoise() const { return mNoise; }
+	void		setNoise( float amplitude );
+
+	// Chance, from 0 to 1, that any one sample is lost
+	float		getPacketLoss() const { return mPacketLoss; }
+	void		setPacketLoss( float probability );
+
+	// EmoStates generated per second, per user
+	float		getStateRate() const { return mStateRate; }
+	void		setStateRate( float rate );
+
+	// Seeds the random generator so runs can be repeated
+	void		setSeed( uint32_t seed );
+
+	// Properties
+	uint32_t	getSampleRate() const { return mSampleRate; }
+
+	// EmotivEngine
+	bool		connect( const std::string &deviceId, const std::string &remoteAddress, uint16_t port );
+	void		disableData( uint32_t userId );
+	bool		disconnect();
+	uint32_t	enableData( uint32_t userId );
+	void		getData( uint32_t userId, int32_t channel, double * dest, uint32_t count );
+	int32_t		getNextEvent( uint32_t &userId, EmotivEvent &event );
+	uint32_t	getNumUsers();
+	bool		loadProfile( const ci::fs::path &profilePath, uint32_t userId );
+	void		setDataBufferSize( double seconds );
+	uint32_t	updateData( uint32_t userId );
+
+private:
+
+	// Constructor
+	EmotivSimulator( uint32_t numUsers, uint32_t sampleRate );
+
+	// Seconds since connecting
+	double					getTime() const;
+
+	// Sine component
+	struct Tone
+	{
+		int32_t				mChannel;
+		float				mAmplitude;
+		float				mFrequency;
+		float				mPhase;
+	};
+
+	// Simulated headset. Samples latched by updateData() are 
+	// kept in one block of mDataCapacity per channel, followed 
+	// by blocks for the packet counter and timestamp.
+	struct User
+	{
+		bool				mAdded;
+		std::vector<double>	mData;
+		uint32_t			mDataCount;
+		double				mNextStateTime;
+		uint64_t			mSampleCount;
+	};
+
+	// Settings
+	float					mNoise;
+	float					mOffset;
+	float					mPacketLoss;
+	uint32_t				mSampleRate;
+	float					mStateRate;
+	std::vector<Tone>		mTones;
+
+	// Session
+	bool					mConnected;
+	uint32_t				mNextUser;
+	ci::Rand				mRand;
+	ci::Timer				mTimer;
+	std::vector<User>		mUsers;
+	uint32_t				mDataCapacity;
+
+};
@@ -0,0 +1,361 @@
+/*
+* 
+* Copyright (c) 2012, Ban the Rewind
+* All rights reserved.
+* 
+* Redistribution and use in source and binary forms, with or 
+* without modification, are permitted provided that the following 
+* conditions are met:
+* 
+* Redistributions of source code must retain the above copyright 
+* notice, this list of conditions and the following disclaimer.
+* Redistributions in binary form must reproduce the above copyright 
+* notice, this list of conditions and the following disclaimer in 
+* the documentation and/or other materials provided with the 
+* distribution.
+* 
+* Neither the name of the Ban the Rewind nor the names of its 
+* contributors may be used to endorse or promote products 
+* derived from this software without specific prior written 
+* permission.
+* 
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS 
+* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT 
+* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS 
+* FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE 
+* COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, 
+* INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+* BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; 
+* LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+* CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, 
+* STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) 
+* ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF 
+* ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+* 
+*/
+
+// Include header
+#include "EmotivSpectrum.h"
+
+// Includes
+#include "cinder/CinderMath.h"
+#include "EmotivKernels.h"
+
+// Imports
+using namespace ci;
+using namespace std;
+
+// Create pointer to spectrum
+EmotivSpectrumRef EmotivSpectrum::create()
+{
+	return EmotivSpectrumRef( new EmotivSpectrum() );
+}
+
+// Constructor
+EmotivSpectrum::EmotivSpectrum()
+{
+
+	// Buffers are sized on the first pass
+	mBinSize = 0;
+	mNumChannels = 0;
+	mWindowFunction = WINDOW_HANN;
+	mWindowSize = 0;
+
+	// Welch defaults to averaging eight one-second segments
+	mMode = MODE_FFT;
+	mSegmentCount = 8;
+	mSegmentSize = 128;
+	resetWelch();
+
+}
+
+// Destructor
+EmotivSpectrum::~EmotivSpectrum()
+{
+	mAmplitude.clear();
+	mFfts.clear();
+	mInput.clear();
+	mPowerSum.clear();
+	mSegmentPower.clear();
+}
+
+// Analyze a window of each channel
+bool EmotivSpectrum::process( const EmotivRingBuffer &buffer, uint32_t windowSize, uint64_t end )
+{
+
+	// Average segments instead in Welch mode
+	if ( mMode == MODE_WELCH ) {
+		return processWelch( buffer, end );
+	}
+
+	// Need a full window
+	if ( windowSize == 0 || windowSize > buffer.getCapacity() || end < windowSize ) {
+		return false;
+	}
+	resize( min<uint32_t>( buffer.getNumChannels(), EmotivBandPower::CHANNEL_COUNT ), buffer.getNumChannels(), windowSize );
+
+	// Copy the window out of the ring
+	if ( buffer.readFrom( &mInput[ 0 ], end - mWindowSize, mWindowSize ) < mWindowSize ) {
+		return false;
+	}
+
+	// Transform channels, spreading them across the pool if there is one
+	double start = mTimer.getSeconds();
+	if ( mTaskPool ) {
+		EmotivSpectrum * spectrum = this;
+		mTaskPool->run( mNumChannels, [ spectrum ]( uint32_t channel )
+		{
+			spectrum->transform( channel );
+		} );
+	} else {
+		for ( uint32_t channel = 0; channel < mNumChannels; channel++ ) {
+			transform( channel );
+		}
+	}
+	mFftTime = mTimer.getSeconds() - start;
+
+	// Reduce each channel to bands once they have all finished
+	reduceBands();
+	return true;
+
+}
+
+// Add every segment completed by "end" to the running average
+bool EmotivSpectrum::processWelch( const EmotivRingBuffer &buffer, uint64_t end )
+{
+
+	// Bail if a segment does not fit
+	if ( mSegmentSize < 2 || mSegmentSize > buffer.getCapacity() ) {
+		return false;
+	}
+
+	// Start over if the shape changes
+	uint32_t numChannels = min<uint32_t>( buffer.getNumChannels(), EmotivBandPower::CHANNEL_COUNT );
+	if ( mSegmentSize != mWindowSize || numChannels != mNumChannels ) {
+		resize( numChannels, buffer.getNumChannels(), mSegmentSize );
+		resetWelch();
+	}
+	if ( mPowerSum.empty() ) {
+		mPowerSum.resize( mNumChannels * mBinSize, 0.0 );
+		mSegmentPower.resize( mNumChannels * mSegmentCount * mBinSize, 0.0f );
+	}
+
+	// Skip segments that are no longer in the buffer without 
+	// leaving the hop grid
+	uint32_t hopSize = max( mSegmentSize / 2, 1u );
+	if ( mSegmentEnd == 0 ) {
+		mSegmentEnd = mSegmentSize;
+	}
+	uint64_t oldest = end > buffer.getCapacity() ? end - buffer.getCapacity() : 0;
+	if ( mSegmentEnd < oldest + mSegmentSize ) {
+		mSegmentEnd += ( ( oldest + mSegmentSize - mSegmentEnd + hopSize - 1 ) / hopSize ) * hopSize;
+	}
+
+	// Transform each completed segment
+	bool added = false;
+	double start = mTimer.getSeconds();
+	for ( ; mSegmentEnd <= end; mSegmentEnd += hopSize ) {
+		if ( buffer.readFrom( &mInput[ 0 ], mSegmentEnd - mSegmentSize, mSegmentSize ) < mSegmentSize ) {
+			continue;
+		}
+		if ( mTaskPool ) {
+			EmotivSpectrum * spectrum = this;
+			mTaskPool->run( mNumChannels, [ spectrum ]( uint32_t channel )
+			{
+				spectrum->transformSegment( channel );
+			} );
+		} else {
+			for ( uint32_t channel = 0; channel < mNumChannels; channel++ ) {
+				transformSegment( channel );
+			}
+		}
+		mSegmentIndex = ( mSegmentIndex + 1 ) % mSegmentCount;
+		mSegmentsAveraged = min( mSegmentsAveraged + 1, mSegmentCount );
+		added = true;
+	}
+	mFftTime = mTimer.getSeconds() - start;
+
+	// Reduce the averaged spectrum
+	if ( added ) {
+		reduceBands();
+	}
+	return added;
+
+}
+
+// Average a band's bins. The table keeps ranges inside the 
+// spectrum so this is a plain contiguous sum.
+float EmotivSpectrum::reduce( const float * amplitude, int32_t band ) const
+{
+	uint32_t begin = mBandTable.getBegin( band );
+	uint32_t end = mBandTable.getEnd( band );
+	if ( end <= begin ) {
+		return 0.0f;
+	}
+	return EmotivKernels::sum( amplitude + begin, end - begin ) * mBandTable.getScale( band );
+}
+
+// Reduce amplitudes to per-channel bands and their average
+void EmotivSpectrum::reduceBands()
+{
+
+	// Map bands to bins for this rate and size
+	double start = mTimer.getSeconds();
+	if ( !mBandTable.matches( mSampleRate, mWindowSize, mBinSize ) ) {
+		mBandTable = getEmotivBandTable( mSampleRate, mWindowSize, mBinSize );
+	}
+
+	// Sum each channel's bands, then average across channels
+	for ( uint32_t channel = 0; channel < mNumChannels; channel++ ) {
+		const float * amplitude = &mAmplitude[ channel * mBinSize ];
+		for ( int32_t band = 0; band < EmotivBandPower::BAND_COUNT; band++ ) {
+			setBand( channel, band, reduce( amplitude, band ) );
+		}
+	}
+	averageBands( mNumChannels );
+	mReduceTime = mTimer.getSeconds() - start;
+
+}
+
+// Clear the Welch average
+void EmotivSpectrum::resetWelch()
+{
+	mPowerSum.clear();
+	mSegmentEnd = 0;
+	mSegmentIndex = 0;
+	mSegmentPower.clear();
+	mSegmentsAveraged = 0;
+}
+
+// Plan FFTs and size buffers, only when the shape changes
+void EmotivSpectrum::resize( uint32_t numChannels, uint32_t inputChannels, uint32_t windowSize )
+{
+	if ( windowSize == mWindowSize && numChannels == mNumChannels && mInput.size() == inputChannels * windowSize ) {
+		return;
+	}
+	mWindowSize = windowSize;
+	mNumChannels = numChannels;
+	while ( mFfts.size() < mNumChannels ) {
+		mFfts.push_back( Kiss::create() );
+	}
+	for ( uint32_t channel = 0; channel < mNumChannels; channel++ ) {
+		mFfts[ channel ]->setDataSize( mWindowSize );
+	}
+	mBinSize = mFfts[ 0 ]->getBinSize();
+	mInput.resize( inputChannels * mWindowSize );
+	mAmplitude.resize( mNumChannels * mBinSize );
+	updateWindow();
+}
+
+// Select spectral mode. Plans are rebuilt on the next pass.
+void EmotivSpectrum::setMode( int32_t mode )
+{
+	if ( mode != mMode ) {
+		mMode = mode;
+		mWindowSize = 0;
+		resetWelch();
+	}
+}
+
+// Set Welch segment size and count
+void EmotivSpectrum::setWelch( uint32_t segmentSize, uint32_t segmentCount )
+{
+	mSegmentCount = max( segmentCount, 1u );
+	mSegmentSize = segmentSize;
+	resetWelch();
+}
+
+// Select window function
+void EmotivSpectrum::setWindowFunction( int32_t windowFunction )
+{
+	if ( windowFunction != mWindowFunction ) {
+		mWindowFunction = windowFunction;
+		updateWindow();
+	}
+}
+
+// Taper a channel, transform it and keep its magnitudes. Channels 
+// touch only their own plan and slice of the buffers.
+void EmotivSpectrum::transform( uint32_t channel )
+{
+	float * input = &mInput[ channel * mWindowSize ];
+	if ( !mWindow.empty() ) {
+		EmotivKernels::multiply( input, &mWindow[ 0 ], input, mWindowSize );
+	}
+	KissRef & fft = mFfts[ channel ];
+	fft->setData( input );
+	memcpy( &mAmplitude[ channel * mBinSize ], fft->getAmplitude(), mBinSize * sizeof( float ) );
+}
+
+// Transform a channel's segment and swap its power spectrum 
+// into the running average in place of the oldest one
+void EmotivSpectrum::transformSegment( uint32_t channel )
+{
+
+	// Taper and transform
+	float * input = &mInput[ channel * mWindowSize ];
+	if ( !mWindow.empty() ) {
+		EmotivKernels::multiply( input, &mWindow[ 0 ], input, mWindowSize );
+	}
+	KissRef & fft = mFfts[ channel ];
+	fft->setData( input );
+
+	// Drop the oldest segment once the average is full
+	float * power = &mSegmentPower[ ( channel * mSegmentCount + mSegmentIndex ) * mBinSize ];
+	double * sum = &mPowerSum[ channel * mBinSize ];
+	if ( mSegmentsAveraged == mSegmentCount ) {
+		for ( uint32_t bin = 0; bin < mBinSize; bin++ ) {
+			sum[ bin ] -= power[ bin ];
+		}
+	}
+
+	// Add this segment's power and take the root of the mean
+	EmotivKernels::power( fft->getReal(), fft->getImaginary(), power, mBinSize );
+	float * amplitude = &mAmplitude[ channel * mBinSize ];
+	double scale = 1.0 / (double)min( mSegmentsAveraged + 1, mSegmentCount );
+	for ( uint32_t bin = 0; bin < mBinSize; bin++ ) {
+		sum[ bin ] = max( sum[ bin ] + (double)power[ bin ], 0.0 );
+		amplitude[ bin ] = static_cast<float>( math<double>::sqrt( sum[ bin ] * scale ) );
+	}
+
+}
+
+// Build window table. Rectangular windows leave it empty 
+// so transform() can skip the multiply.
+void EmotivSpectrum::updateWindow()
+{
+
+	// Bail if there is nothing to taper
+	mWindow.clear();
+	if ( mWindowFunction == WINDOW_RECTANGULAR || mWindowSize < 2 ) {
+		return;
+	}
+
+	// Generalized cosine window coefficients
+	double a0 = 0.5;
+	double a1 = 0.5;
+	double a2 = 0.0;
+	if ( mWindowFunction == WINDOW_HAMMING ) {
+		a0 = 0.54;
+		a1 = 0.46;
+	} else if ( mWindowFunction == WINDOW_BLACKMAN ) {
+		a0 = 0.42;
+		a1 = 0.5;
+		a2 = 0.08;
+	}
+
+	// Fill the periodic window and scale it to a mean of one
+	mWindow.resize( mWindowSize );
+	double sum = 0.0;
+	for ( uint32_t i = 0; i < mWindowSize; i++ ) {
+		double phase = 2.0 * M_PI * (double)i / (double)mWindowSize;
+		double value = a0 - a1 * math<double>::cos( phase ) + a2 * math<double>::cos( 2.0 * phase );
+		mWindow[ i ] = static_cast<float>( value );
+		sum += value;
+	}
+	float scale = static_cast<float>( (double)mWindowSize / sum );
+	for ( uint32_t i = 0; i < mWindowSize; i++ ) {
+		mWindow[ i ] *= scale;
+	}
+
+}
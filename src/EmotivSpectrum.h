@@ -0,0 +1,161 @@
+/*
+* 
+* Copyright (c) 2012, Ban the Rewind
+* All rights reserved.
+* 
+* Redistribution and use in source and binary forms, with or 
+* without modification, are permitted provided that the following 
+* conditions are met:
+* 
+* Redistributions of source code must retain the above copyright 
+* notice, this list of conditions and the following disclaimer.
+* Redistributions in binary form must reproduce the above copyright 
+* notice, this list of conditions and the following disclaimer in 
+* the documentation and/or other materials provided with the 
+* distribution.
+* 
+* Neither the name of the Ban the Rewind nor the names of its 
+* contributors may be used to endorse or promote products 
+* derived from this software without specific prior written 
+* permission.
+* 
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS 
+* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT 
+* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS 
+* FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE 
+* COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, 
+* INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+* BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; 
+* LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+* CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, 
+* STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) 
+* ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF 
+* ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+* 
+*/
+
+#pragma once
+
+// Includes
+#include "EmotivAnalyzer.h"
+#include "KissFFT.h"
+#include <vector>
+
+// Spectrum pointer alias
+typedef std::shared_ptr<class EmotivSpectrum> EmotivSpectrumRef;
+
+/*
+ * Runs an FFT over a window of every channel in a raw EEG
+ * buffer and reduces each channel's spectrum to band powers.
+ * Each window is tapered by a window function first.
+ * Each channel has its own FFT plan, created once per window 
+ * size, so channels can be transformed in parallel on a task 
+ * pool.
+ *
+ * In MODE_WELCH the spectrum is instead estimated with Welch's 
+ * method: short segments overlapping by half are transformed as 
+ * they complete and the power of the last "segmentCount" of them 
+ * is averaged. Running sums are kept per bin, so each new segment 
+ * costs one short FFT per channel however many are averaged. 
+ * Amplitudes are then the root of the mean power in each bin.
+ */
+class EmotivSpectrum : public EmotivAnalyzer
+{
+
+public:
+
+	// Spectral modes
+	static const int32_t MODE_FFT			= 0;
+	static const int32_t MODE_WELCH			= 1;
+
+	// Window functions
+	static const int32_t WINDOW_RECTANGULAR	= 0;
+	static const int32_t WINDOW_HANN		= 1;
+	static const int32_t WINDOW_HAMMING		= 2;
+	static const int32_t WINDOW_BLACKMAN	= 3;
+
+	// Create pointer to spectrum
+	static EmotivSpectrumRef	create();
+
+	// Destructor
+	~EmotivSpectrum();
+
+	// Analyzes the "windowSize" samples of each channel that end 
+	// just before sample index "end". Pass the buffer's write count 
+	// to analyze the latest window. Returns false if the window 
+	// is not (or no longer) in the buffer. In MODE_WELCH, every 
+	// segment completed by "end" is added to the average instead, 
+	// and "windowSize" is ignored. Returns false if there were none.
+	bool						process( const EmotivRingBuffer &buffer, uint32_t windowSize, uint64_t end );
+
+	// Spectral mode, MODE_FFT (default) or MODE_WELCH. Changing 
+	// mode or Welch parameters starts a new average.
+	int32_t						getMode() const { return mMode; }
+	uint32_t					getSegmentCount() const { return mSegmentCount; }
+	uint32_t					getSegmentSize() const { return mSegmentSize; }
+	void						setMode( int32_t mode );
+	void						setWelch( uint32_t segmentSize, uint32_t segmentCount );
+
+	// Window function applied to each channel before its FFT. 
+	// Windows are scaled to a mean of one, so a tone's amplitude 
+	// matches the rectangular window's. Defaults to WINDOW_HANN.
+	int32_t						getWindowFunction() const { return mWindowFunction; }
+	void						setWindowFunction( int32_t windowFunction );
+
+	// Results of the last pass
+	const float *				getAmplitude( uint32_t channel ) const { return &mAmplitude[ channel * mBinSize ]; }
+	uint32_t					getBinSize() const { return mBinSize; }
+	uint32_t					getNumChannels() const { return mNumChannels; }
+	uint32_t					getWindowSize() const { return mWindowSize; }
+
+private:
+
+	// Constructor
+	EmotivSpectrum();
+
+	// Averages a band's bins of an amplitude spectrum
+	float						reduce( const float * amplitude, int32_t band ) const;
+
+	// Reduces every channel's amplitudes to bands
+	void						reduceBands();
+
+	// Plans FFTs and sizes buffers for "numChannels" channels of 
+	// "windowSize" samples
+	void						resize( uint32_t numChannels, uint32_t inputChannels, uint32_t windowSize );
+
+	// Transforms one channel of the copied window
+	void						transform( uint32_t channel );
+
+	// Welch mode. "mSegmentEnd" is the end sample of the next 
+	// segment. Power spectra of the last mSegmentCount segments 
+	// are kept per channel in mSegmentPower, oldest overwritten 
+	// first, with their sum in mPowerSum.
+	bool						processWelch( const EmotivRingBuffer &buffer, uint64_t end );
+	void						resetWelch();
+	void						transformSegment( uint32_t channel );
+	int32_t						mMode;
+	std::vector<double>			mPowerSum;
+	uint32_t					mSegmentCount;
+	uint64_t					mSegmentEnd;
+	uint32_t					mSegmentIndex;
+	std::vector<float>			mSegmentPower;
+	uint32_t					mSegmentSize;
+	uint32_t					mSegmentsAveraged;
+
+	// FFT
+	std::vector<float>			mAmplitude;
+	uint32_t					mBinSize;
+	std::vector<KissRef>		mFfts;
+	std::vector<float>			mInput;
+	uint32_t					mNumChannels;
+	uint32_t					mWindowSize;
+
+	// Window function, rebuilt when the size or function changes
+	std::vector<float>			mWindow;
+	int32_t						mWindowFunction;
+	void						updateWindow();
+
+	// Bands
+	EmotivBandTable				mBandTable;
+
+};
@@ -0,0 +1,89 @@
+/*
+* 
+* Copyright (c) 2012, Ban the Rewind
+* All rights reserved.
+* 
+* Redistribution and use in source and binary forms, with or 
+* without modification, are permitted provided that the following 
+* conditions are met:
+* 
+* Redistributions of source code must retain the above copyright 
+* notice, this list of conditions and the following disclaimer.
+* Redistributions in binary form must reproduce the above copyright 
+* notice, this list of conditions and the following disclaimer in 
+* the documentation and/or other materials provided with the 
+* distribution.
+* 
+* Neither the name of the Ban the Rewind nor the names of its 
+* contributors may be used to endorse or promote products 
+* derived from this software without specific prior written 
+* permission.
+* 
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS 
+* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT 
+* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS 
+* FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE 
+* COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, 
+* INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+* BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; 
+* LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+* CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, 
+* STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) 
+* ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF 
+* ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+* 
+*/
+
+#pragma once
+
+// Includes
+#include "cinder/Cinder.h"
+#include "EmotivEngine.h"
+
+/*
+ * Snapshot of Emotiv's runtime counters, returned by 
+ * Emotiv::getStats(). Rates cover the last full second.
+ */
+struct EmotivStats
+{
+
+	// Engine events per second, indexed by EmotivEngine event 
+	// type (EVENT_USER_ADDED, EVENT_STATE_UPDATED, ...)
+	double		mEventsPerSecond[ EmotivEngine::EVENT_TYPE_COUNT ];
+
+	// Total events handled, raw samples copied into ring buffers 
+	// and samples found missing from gaps in the headset counter
+	uint64_t	mEventCount;
+	uint64_t	mSamplesAcquired;
+	uint64_t	mSamplesLost;
+
+	// Gaps found between samples, wraparounds of the headset 
+	// counter, lost samples filled in by interpolation (see 
+	// Emotiv::setGapFill()) and samples that repeated the last 
+	// counter value
+	uint64_t	mGapCount;
+	uint64_t	mCounterWraps;
+	uint64_t	mSamplesInterpolated;
+	uint64_t	mSamplesDuplicated;
+
+	// Seconds between the newest sample of the last block being 
+	// taken and Emotiv fetching it, from the headset's timestamps. 
+	// The two clocks are only related through the blocks themselves, 
+	// so this is measured against the quickest block seen and shows 
+	// delay added by transport and polling rather than the total.
+	double		mAcquisitionLatency;
+
+	// Seconds spent in the last analysis pass (FFT and band 
+	// reduction) and in the last dispatch
+	double		mFftTime;
+	double		mCallbackTime;
+
+	// Events waiting for poll() in DISPATCH_QUEUED mode
+	uint32_t	mQueueDepth;
+
+	// Passes through the acquisition loop per handled event. 
+	// Values well above one mean the thread spends most of its 
+	// time polling an idle engine.
+	double		mLoopIterationsPerEvent;
+
+};
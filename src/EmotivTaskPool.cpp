@@ -0,0 +1,247 @@
+/*
+* 
+* Copyright (c) 2012, Ban the Rewind
+* All rights reserved.
+* 
+* Redistribution and use in source and binary forms, with or 
+* without modification, are permitted provided that the following 
+* conditions are met:
+* 
+* Redistributions of source code must retain the above copyright 
+* notice, this list of conditions and the following disclaimer.
+* Redistributions in binary form must reproduce the above copyright 
+* notice, this list of conditions and the following disclaimer in 
+* the documentation and/or other materials provided with the 
+* distribution.
+* 
+* Neither the name of the Ban the Rewind nor the names of its 
+* contributors may be used to endorse or promote products 
+* derived from this software without specific prior written 
+* permission.
+* 
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS 
+* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT 
+* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS 
+* FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE 
+* COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, 
+* INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+* BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; 
+* LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+* CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, 
+* STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) 
+* ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF 
+* ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+* 
+*/
+
+// Include header
+#include "EmotivTaskPool.h"
+
+// Imports
+using namespace std;
+
+// Tasks each queue can hold
+static const uint32_t QUEUE_CAPACITY = 256;
+
+// Create pointer to pool
+EmotivTaskPoolRef EmotivTaskPool::create( uint32_t numThreads )
+{
+	if ( numThreads == 0 ) {
+		numThreads = max( boost::thread::hardware_concurrency(), 2u ) - 1;
+	}
+	return EmotivTaskPoolRef( new EmotivTaskPool( numThreads ) );
+}
+
+// Constructor
+EmotivTaskPool::EmotivTaskPool( uint32_t numThreads )
+	: mPending( 0 )
+{
+
+	// One queue per worker plus one for the caller
+	mNumThreads = numThreads;
+	for ( uint32_t i = 0; i <= mNumThreads; i++ ) {
+		std::shared_ptr<Queue> queue( new Queue() );
+		queue->mCount = 0;
+		queue->mFront = 0;
+		queue->mTasks.resize( QUEUE_CAPACITY );
+		mQueues.push_back( queue );
+	}
+
+	// Start workers
+	mRunning = true;
+	for ( uint32_t i = 0; i < mNumThreads; i++ ) {
+		mThreads.push_back( std::shared_ptr<boost::thread>( new boost::thread( boost::bind( &EmotivTaskPool::work, this, i ) ) ) );
+	}
+
+}
+
+// Destructor
+EmotivTaskPool::~EmotivTaskPool()
+{
+
+	// Wake and join workers
+	{
+		boost::mutex::scoped_lock lock( mMutex );
+		mRunning = false;
+	}
+	mCondition.notify_all();
+	for ( vector<std::shared_ptr<boost::thread> >::iterator threadIt = mThreads.begin(); threadIt != mThreads.end(); ++threadIt ) {
+		( *threadIt )->join();
+	}
+
+}
+
+// Run a job across the pool
+void EmotivTaskPool::execute( Job &job, uint32_t count )
+{
+
+	// Nothing to spread
+	if ( count == 0 ) {
+		return;
+	}
+	uint32_t caller = mNumThreads;
+	if ( mNumThreads == 0 || count == 1 ) {
+		for ( uint32_t i = 0; i < count; i++ ) {
+			job.mInvoke( job.mContext, i );
+		}
+		return;
+	}
+
+	// Deal one slice of the range to each worker's queue and 
+	// keep the first for this thread
+	job.mRemaining = count;
+	uint32_t numSlices = min( count, mNumThreads + 1 );
+	Task first;
+	for ( uint32_t slice = 0; slice < numSlices; slice++ ) {
+		Task task;
+		task.mBegin = (uint32_t)( (uint64_t)count * slice / numSlices );
+		task.mEnd = (uint32_t)( (uint64_t)count * ( slice + 1 ) / numSlices );
+		task.mJob = &job;
+		if ( slice == 0 ) {
+			first = task;
+		} else if ( !push( slice - 1, task ) ) {
+			execute( caller, task );
+		}
+	}
+
+	// Wake workers
+	{
+		boost::mutex::scoped_lock lock( mMutex );
+	}
+	mCondition.notify_all();
+
+	// Work until the job is done, helping with whatever is queued
+	execute( caller, first );
+	while ( job.mRemaining.load( boost::memory_order_acquire ) > 0 ) {
+		Task task;
+		if ( find( caller, task ) ) {
+			execute( caller, task );
+		} else {
+			boost::this_thread::yield();
+		}
+	}
+
+}
+
+// Run one task
+void EmotivTaskPool::execute( uint32_t queue, Task task )
+{
+
+	// Leave the upper half of the range for thieves
+	while ( task.mEnd - task.mBegin > 1 ) {
+		Task rest = task;
+		rest.mBegin = task.mBegin + ( task.mEnd - task.mBegin ) / 2;
+		if ( !push( queue, rest ) ) {
+			break;
+		}
+		task.mEnd = rest.mBegin;
+	}
+
+	// Run what is left and mark it done
+	for ( uint32_t i = task.mBegin; i < task.mEnd; i++ ) {
+		task.mJob->mInvoke( task.mJob->mContext, i );
+	}
+	task.mJob->mRemaining.fetch_sub( task.mEnd - task.mBegin, boost::memory_order_release );
+
+}
+
+// Find work in own queue, then steal
+bool EmotivTaskPool::find( uint32_t queue, Task &task )
+{
+	if ( popBack( queue, task ) ) {
+		return true;
+	}
+	for ( uint32_t i = 1; i < mQueues.size(); i++ ) {
+		if ( popFront( ( queue + i ) % mQueues.size(), task ) ) {
+			return true;
+		}
+	}
+	return false;
+}
+
+// Take newest task from a queue
+bool EmotivTaskPool::popBack( uint32_t queue, Task &task )
+{
+	Queue & q = *mQueues[ queue ];
+	boost::mutex::scoped_lock lock( q.mMutex );
+	if ( q.mCount == 0 ) {
+		return false;
+	}
+	q.mCount--;
+	task = q.mTasks[ ( q.mFront + q.mCount ) % QUEUE_CAPACITY ];
+	mPending.fetch_sub( 1, boost::memory_order_relaxed );
+	return true;
+}
+
+// Take oldest task from a queue
+bool EmotivTaskPool::popFront( uint32_t queue, Task &task )
+{
+	Queue & q = *mQueues[ queue ];
+	boost::mutex::scoped_lock lock( q.mMutex );
+	if ( q.mCount == 0 ) {
+		return false;
+	}
+	task = q.mTasks[ q.mFront ];
+	q.mFront = ( q.mFront + 1 ) % QUEUE_CAPACITY;
+	q.mCount--;
+	mPending.fetch_sub( 1, boost::memory_order_relaxed );
+	return true;
+}
+
+// Add task to the back of a queue
+bool EmotivTaskPool::push( uint32_t queue, const Task &task )
+{
+	Queue & q = *mQueues[ queue ];
+	boost::mutex::scoped_lock lock( q.mMutex );
+	if ( q.mCount == QUEUE_CAPACITY ) {
+		return false;
+	}
+	q.mTasks[ ( q.mFront + q.mCount ) % QUEUE_CAPACITY ] = task;
+	q.mCount++;
+	mPending.fetch_add( 1, boost::memory_order_release );
+	return true;
+}
+
+// Worker loop
+void EmotivTaskPool::work( uint32_t queue )
+{
+	while ( true ) {
+
+		// Run or steal tasks while there are any
+		Task task;
+		if ( find( queue, task ) ) {
+			execute( queue, task );
+			continue;
+		}
+
+		// Sleep until run() deals more work or the pool stops
+		boost::mutex::scoped_lock lock( mMutex );
+		while ( mRunning && mPending.load( boost::memory_order_acquire ) == 0 ) {
+			mCondition.wait( lock );
+		}
+		if ( !mRunning ) {
+			break;
+		}
+
+	}
+}
@@ -0,0 +1,151 @@
+/*
+* 
+* Copyright (c) 2012, Ban the Rewind
+* All rights reserved.
+* 
+* Redistribution and use in source and binary forms, with or 
+* without modification, are permitted provided that the following 
+* conditions are met:
+* 
+* Redistributions of source code must retain the above copyright 
+* notice, this list of conditions and the following disclaimer.
+* Redistributions in binary form must reproduce the above copyright 
+* notice, this list of conditions and the following disclaimer in 
+* the documentation and/or other materials provided with the 
+* distribution.
+* 
+* Neither the name of the Ban the Rewind nor the names of its 
+* contributors may be used to endorse or promote products 
+* derived from this software without specific prior written 
+* permission.
+* 
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS 
+* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT 
+* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS 
+* FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE 
+* COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, 
+* INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+* BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; 
+* LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+* CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, 
+* STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) 
+* ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF 
+* ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+* 
+*/
+
+#pragma once
+
+// Includes
+#include "boost/atomic.hpp"
+#include "boost/thread/condition_variable.hpp"
+#include "boost/thread/mutex.hpp"
+#include "boost/thread/thread.hpp"
+#include "cinder/Cinder.h"
+#include <vector>
+
+// Task pool pointer alias
+typedef std::shared_ptr<class EmotivTaskPool> EmotivTaskPoolRef;
+
+/*
+ * Fixed set of worker threads for data-parallel DSP work. run() 
+ * splits an index range across per-thread queues. Each thread 
+ * halves the range it holds, keeping one half and leaving the other 
+ * in its queue. Idle threads steal from the front of other queues, 
+ * so the load balances itself. The calling thread joins in and 
+ * returns once every index has been handled. No memory is 
+ * allocated after creation.
+ */
+class EmotivTaskPool
+{
+
+public:
+
+	// Create pointer to pool with "numThreads" workers. Pass zero 
+	// to use one less than the number of hardware threads, since 
+	// the caller works too.
+	static EmotivTaskPoolRef	create( uint32_t numThreads = 0 );
+
+	// Destructor. Stops and joins the workers.
+	~EmotivTaskPool();
+
+	// Number of worker threads, not counting the caller
+	uint32_t					getNumThreads() const { return mNumThreads; }
+
+	// Calls "task( i )" for each "i" in [ 0, count ) on the workers 
+	// and the calling thread, and returns when all calls are done. 
+	// "task" is any function object taking a uint32_t. The calls 
+	// run in no particular order and must not depend on each other.
+	template<typename T>
+	void						run( uint32_t count, const T &task )
+	{
+		Job job;
+		job.mContext = &task;
+		job.mInvoke = &invoke<T>;
+		execute( job, count );
+	}
+
+private:
+
+	// Constructor
+	EmotivTaskPool( uint32_t numThreads );
+
+	// A call to run()
+	struct Job
+	{
+		const void *				mContext;
+		void						( * mInvoke )( const void * context, uint32_t index );
+		boost::atomic<uint32_t>		mRemaining;
+	};
+
+	// Calls a typed function object through a Job
+	template<typename T>
+	static void					invoke( const void * context, uint32_t index )
+	{
+		( *static_cast<const T *>( context ) )( index );
+	}
+
+	// A range of indices [ mBegin, mEnd ) of a job
+	struct Task
+	{
+		uint32_t				mBegin;
+		uint32_t				mEnd;
+		Job *					mJob;
+	};
+
+	// Fixed-capacity deque of tasks. The owner works at the 
+	// back, thieves take from the front.
+	struct Queue
+	{
+		uint32_t				mCount;
+		uint32_t				mFront;
+		boost::mutex			mMutex;
+		std::vector<Task>		mTasks;
+	};
+
+	// Queue access. Return false if the queue is full or empty.
+	bool						popBack( uint32_t queue, Task &task );
+	bool						popFront( uint32_t queue, Task &task );
+	bool						push( uint32_t queue, const Task &task );
+
+	// Runs a task, splitting it while it is larger than one index 
+	// so the rest can be stolen from "queue"
+	void						execute( uint32_t queue, Task task );
+	void						execute( Job &job, uint32_t count );
+
+	// Finds work in "queue" or steals it from another
+	bool						find( uint32_t queue, Task &task );
+
+	// Queues. The caller uses the last one.
+	std::vector<std::shared_ptr<Queue> >	mQueues;
+
+	// Workers
+	boost::condition_variable				mCondition;
+	boost::mutex							mMutex;
+	uint32_t								mNumThreads;
+	boost::atomic<uint32_t>					mPending;
+	bool									mRunning;
+	std::vector<std::shared_ptr<boost::thread> >	mThreads;
+	void									work( uint32_t queue );
+
+};
@@ -0,0 +1,267 @@
+/*
+* 
+* Copyright (c) 2012, Ban the Rewind
+* All rights reserved.
+* 
+* Redistribution and use in source and binary forms, with or 
+* without modification, are permitted provided that the following 
+* conditions are met:
+* 
+* Redistributions of source code must retain the above copyright 
+* notice, this list of conditions and the following disclaimer.
+* Redistributions in binary form must reproduce the above copyright 
+* notice, this list of conditions and the following disclaimer in 
+* the documentation and/or other materials provided with the 
+* distribution.
+* 
+* Neither the name of the Ban the Rewind nor the names of its 
+* contributors may be used to endorse or promote products 
+* derived from this software without specific prior written 
+* permission.
+* 
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS 
+* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT 
+* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS 
+* FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE 
+* COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, 
+* INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+* BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; 
+* LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+* CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, 
+* STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) 
+* ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF 
+* ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+* 
+*/
+
+// Include header
+#include "EmotivWavelet.h"
+
+// Includes
+#include "cinder/CinderMath.h"
+
+// Imports
+using namespace ci;
+using namespace std;
+
+// Samples decomposed per pass
+static const uint32_t MAX_FRAMES = 256;
+
+// Daubechies-4 decomposition filters, newest sample first
+static const float DB4_LOW[ 8 ] = { 
+	-0.010597401784997278f, 0.032883011666982945f, 0.030841381835986965f, -0.18703481171888114f, 
+	-0.02798376941698385f, 0.6308807679295904f, 0.7148465705525415f, 0.23037781330885523f 
+};
+static const float DB4_HIGH[ 8 ] = { 
+	-0.23037781330885523f, 0.7148465705525415f, -0.6308807679295904f, -0.02798376941698385f, 
+	0.18703481171888114f, 0.030841381835986965f, -0.032883011666982945f, -0.010597401784997278f 
+};
+
+// Create pointer to wavelet analyzer
+EmotivWaveletRef EmotivWavelet::create()
+{
+	return EmotivWaveletRef( new EmotivWavelet() );
+}
+
+// Constructor
+EmotivWavelet::EmotivWavelet()
+{
+	mConfigured = false;
+	for ( uint32_t level = 0; level < MAX_LEVELS; level++ ) {
+		mLevelBands[ level ] = -1;
+	}
+	mNext = 0;
+	mNumChannels = 0;
+	mNumLevels = 0;
+	mPrimed = false;
+	mWindowSize = 0;
+}
+
+// Run new samples through the cascade
+void EmotivWavelet::decompose( uint32_t channel, uint32_t count )
+{
+	const float * input = &mInput[ channel * count ];
+	Level * levels = &mLevels[ channel * MAX_LEVELS ];
+	for ( uint32_t i = 0; i < count; i++ ) {
+
+		// Each level passes its approximation down on every 
+		// second input and stops the cascade otherwise
+		float value = input[ i ];
+		for ( uint32_t l = 0; l < mNumLevels; l++ ) {
+			Level & level = levels[ l ];
+			level.mHistory[ level.mPosition ] = value;
+			level.mHistory[ level.mPosition + TAP_COUNT ] = value;
+			const float * newest = &level.mHistory[ level.mPosition + TAP_COUNT ];
+			level.mPosition = ( level.mPosition + 1 ) % TAP_COUNT;
+			level.mPhase ^= 1;
+			if ( level.mPhase != 0 ) {
+				break;
+			}
+
+			// Convolve
+			float approximation = 0.0f;
+			float detail = 0.0f;
+			for ( uint32_t tap = 0; tap < TAP_COUNT; tap++ ) {
+				approximation += DB4_LOW[ tap ] * newest[ -(int32_t)tap ];
+				detail += DB4_HIGH[ tap ] * newest[ -(int32_t)tap ];
+			}
+
+			// Slide energy window, summing it afresh on each 
+			// lap so rounding can't build up
+			float energy = detail * detail;
+			uint32_t size = static_cast<uint32_t>( level.mEnergy.size() );
+			if ( level.mEnergyCount == size ) {
+				level.mEnergySum -= level.mEnergy[ level.mEnergyPosition ];
+			} else {
+				level.mEnergyCount++;
+			}
+			level.mEnergy[ level.mEnergyPosition ] = energy;
+			level.mEnergySum += energy;
+			if ( ++level.mEnergyPosition == size ) {
+				level.mEnergyPosition = 0;
+				level.mEnergySum = 0.0;
+				for ( uint32_t j = 0; j < size; j++ ) {
+					level.mEnergySum += level.mEnergy[ j ];
+				}
+			}
+
+			value = approximation;
+		}
+
+	}
+}
+
+// Get level amplitude
+float EmotivWavelet::getLevelAmplitude( uint32_t channel, uint32_t level ) const
+{
+	if ( channel >= mNumChannels || level >= mNumLevels ) {
+		return 0.0f;
+	}
+
+	// Mean power per input sample. A level's details each 
+	// stand for 2 ^ ( level + 1 ) samples.
+	const Level & state = mLevels[ channel * MAX_LEVELS + level ];
+	if ( state.mEnergyCount == 0 ) {
+		return 0.0f;
+	}
+	double power = state.mEnergySum / ( (double)state.mEnergyCount * (double)( 2u << level ) );
+	return static_cast<float>( math<double>::sqrt( 2.0 * max( power, 0.0 ) ) );
+}
+
+// Decompose new samples
+bool EmotivWavelet::process( const EmotivRingBuffer &buffer, uint32_t windowSize, uint64_t end )
+{
+
+	// Start over if the shape changes
+	uint32_t numChannels = min<uint32_t>( buffer.getNumChannels(), EmotivBandPower::CHANNEL_COUNT );
+	if ( !mConfigured || numChannels != mNumChannels || windowSize != mWindowSize ) {
+		resize( numChannels, buffer.getNumChannels(), windowSize );
+	}
+
+	// Restart after a gap, settling on the last window
+	uint64_t oldest = end > buffer.getCapacity() ? end - buffer.getCapacity() : 0;
+	if ( !mPrimed || mNext < oldest || mNext > end ) {
+		reset();
+		mNext = max( end > windowSize ? end - windowSize : 0, oldest );
+		mPrimed = true;
+	}
+	if ( mNext >= end ) {
+		return false;
+	}
+
+	// Decompose in passes of up to MAX_FRAMES
+	double start = mTimer.getSeconds();
+	while ( mNext < end ) {
+		uint32_t count = static_cast<uint32_t>( min<uint64_t>( end - mNext, MAX_FRAMES ) );
+		if ( buffer.readFrom( &mInput[ 0 ], mNext, count ) < count ) {
+			mPrimed = false;
+			return false;
+		}
+		if ( mTaskPool ) {
+			EmotivWavelet * wavelet = this;
+			mTaskPool->run( mNumChannels, [ wavelet, count ]( uint32_t channel )
+			{
+				wavelet->decompose( channel, count );
+			} );
+		} else {
+			for ( uint32_t channel = 0; channel < mNumChannels; channel++ ) {
+				decompose( channel, count );
+			}
+		}
+		mNext += count;
+	}
+	double decomposed = mTimer.getSeconds();
+	mFftTime = decomposed - start;
+
+	// Add up level powers per band
+	for ( uint32_t channel = 0; channel < mNumChannels; channel++ ) {
+		float power[ EmotivBandPower::BAND_COUNT ] = { 0.0f };
+		for ( uint32_t level = 0; level < mNumLevels; level++ ) {
+			float amplitude = getLevelAmplitude( channel, level );
+			power[ mLevelBands[ level ] ] += amplitude * amplitude;
+		}
+		for ( int32_t band = 0; band < EmotivBandPower::BAND_COUNT; band++ ) {
+			setBand( channel, band, math<float>::sqrt( power[ band ] ) );
+		}
+	}
+	averageBands( mNumChannels );
+	mReduceTime = mTimer.getSeconds() - decomposed;
+	return true;
+
+}
+
+// Clear levels
+void EmotivWavelet::reset()
+{
+	for ( vector<Level>::iterator levelIt = mLevels.begin(); levelIt != mLevels.end(); ++levelIt ) {
+		fill( levelIt->mEnergy.begin(), levelIt->mEnergy.end(), 0.0f );
+		levelIt->mEnergyCount = 0;
+		levelIt->mEnergyPosition = 0;
+		levelIt->mEnergySum = 0.0;
+		fill( levelIt->mHistory, levelIt->mHistory + TAP_COUNT * 2, 0.0f );
+		levelIt->mPhase = 0;
+		levelIt->mPosition = 0;
+	}
+}
+
+// Map levels to bands and size buffers
+void EmotivWavelet::resize( uint32_t numChannels, uint32_t inputChannels, uint32_t windowSize )
+{
+
+	// Level "l" holds [ rate / 2 ^ ( l + 2 ), rate / 2 ^ ( l + 1 ) ). 
+	// Stop at the first level centred below delta.
+	mNumLevels = 0;
+	for ( uint32_t level = 0; level < MAX_LEVELS; level++ ) {
+		float centre = mSampleRate / (float)( 4u << level ) * math<float>::sqrt( 2.0f );
+		mLevelBands[ level ] = getEmotivBand( centre );
+		if ( mLevelBands[ level ] < 0 ) {
+			break;
+		}
+		mNumLevels++;
+	}
+
+	// Each level keeps the details covering one window
+	mNumChannels = numChannels;
+	mWindowSize = windowSize;
+	mLevels.resize( mNumChannels * MAX_LEVELS );
+	for ( uint32_t channel = 0; channel < mNumChannels; channel++ ) {
+		for ( uint32_t level = 0; level < MAX_LEVELS; level++ ) {
+			uint32_t span = 2u << level;
+			mLevels[ channel * MAX_LEVELS + level ].mEnergy.resize( max<uint32_t>( ( mWindowSize + span - 1 ) / span, 1 ) );
+		}
+	}
+	mInput.resize( inputChannels * MAX_FRAMES );
+	reset();
+	mConfigured = true;
+	mPrimed = false;
+
+}
+
+// Remap levels at the new rate
+void EmotivWavelet::setSampleRate( float sampleRate )
+{
+	if ( sampleRate != mSampleRate ) {
+		mSampleRate = sampleRate;
+		mConfigured = false;
+	}
+}
@@ -0,0 +1,133 @@
+/*
+* 
+* Copyright (c) 2012, Ban the Rewind
+* All rights reserved.
+* 
+* Redistribution and use in source and binary forms, with or 
+* without modification, are permitted provided that the following 
+* conditions are met:
+* 
+* Redistributions of source code must retain the above copyright 
+* notice, this list of conditions and the following disclaimer.
+* Redistributions in binary form must reproduce the above copyright 
+* notice, this list of conditions and the following disclaimer in 
+* the documentation and/or other materials provided with the 
+* distribution.
+* 
+* Neither the name of the Ban the Rewind nor the names of its 
+* contributors may be used to endorse or promote products 
+* derived from this software without specific prior written 
+* permission.
+* 
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS 
+* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT 
+* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS 
+* FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE 
+* COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, 
+* INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+* BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; 
+* LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+* CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, 
+* STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) 
+* ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF 
+* ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+* 
+*/
+
+#pragma once
+
+// Includes
+#include "EmotivAnalyzer.h"
+#include <vector>
+
+// Wavelet pointer alias
+typedef std::shared_ptr<class EmotivWavelet> EmotivWaveletRef;
+
+/*
+ * Splits each channel into octaves with a Daubechies-4 (eight tap) 
+ * discrete wavelet transform, run as a streaming cascade: every 
+ * level halves the rate of the approximation it is fed and emits 
+ * a detail coefficient for every second input. At 128Hz the 
+ * details of levels 1 to 6 cover 32-64, 16-32, 8-16, 4-8, 2-4 and 
+ * 1-2Hz, which land on gamma, beta, alpha, theta and delta (the 
+ * last two). Each level is assigned to the band holding its 
+ * geometric centre, so other rates work too.
+ *
+ * Band energy is the sum of squared detail coefficients over the 
+ * last "windowSize" samples, kept as a running sum per level, so 
+ * each new sample costs O(1) regardless of the window. Amplitudes 
+ * read as the peak of a sine carrying the same energy, in signal 
+ * units rather than FFT bin scale.
+ */
+class EmotivWavelet : public EmotivAnalyzer
+{
+
+public:
+
+	// Most levels decomposed
+	static const uint32_t		MAX_LEVELS = 8;
+
+	// Create pointer to wavelet analyzer
+	static EmotivWaveletRef		create();
+
+	// Decomposes every sample before "end" not seen yet. Starts 
+	// over from the last "windowSize" samples if the window size 
+	// changes or samples it needs have been overwritten. Returns 
+	// false if there were no new samples.
+	bool						process( const EmotivRingBuffer &buffer, uint32_t windowSize, uint64_t end );
+	bool						isStreaming() const { return true; }
+	void						setSampleRate( float sampleRate );
+
+	// Levels in use and the band each one feeds. Level zero has 
+	// the highest frequencies.
+	int32_t						getLevelBand( uint32_t level ) const { return mLevelBands[ level ]; }
+	uint32_t					getNumLevels() const { return mNumLevels; }
+
+	// Amplitude of one level of a channel from the last pass
+	float						getLevelAmplitude( uint32_t channel, uint32_t level ) const;
+
+private:
+
+	// Constructor
+	EmotivWavelet();
+
+	// Filter length
+	static const uint32_t		TAP_COUNT = 8;
+
+	// Streaming state of one level. Inputs are written twice, 
+	// "TAP_COUNT" apart, so the last TAP_COUNT of them are always 
+	// contiguous. "mEnergy" is a ring of squared details.
+	struct Level
+	{
+		std::vector<float>	mEnergy;
+		uint32_t			mEnergyCount;
+		uint32_t			mEnergyPosition;
+		double				mEnergySum;
+		float				mHistory[ TAP_COUNT * 2 ];
+		uint32_t			mPhase;
+		uint32_t			mPosition;
+	};
+
+	// Feeds a block of samples through one channel's levels
+	void						decompose( uint32_t channel, uint32_t count );
+
+	// Sizes levels for the sample rate and window, clearing state
+	void						resize( uint32_t numChannels, uint32_t inputChannels, uint32_t windowSize );
+
+	// Clears every level's state
+	void						reset();
+
+	// Levels, "MAX_LEVELS" per channel
+	bool						mConfigured;
+	std::vector<Level>			mLevels;
+	int32_t						mLevelBands[ MAX_LEVELS ];
+	uint32_t					mNumChannels;
+	uint32_t					mNumLevels;
+	uint32_t					mWindowSize;
+
+	// Input
+	std::vector<float>			mInput;
+	uint64_t					mNext;
+	bool						mPrimed;
+
+};